@@ -60,18 +60,33 @@ TEMPLATE = app
 SOURCES += main.cpp \
            mainwindow.cpp \
            utils/sonicpiapis.cpp \
+           utils/fuzzymatcher.cpp \
+           utils/rubyindenter.cpp \
+           utils/rubyblockindex.cpp \
+           utils/linediff.cpp \
            osc/oschandler.cpp \
            osc/oscsender.cpp \
            osc/sonic_pi_osc_server.cpp \
            osc/sonic_pi_udp_osc_server.cpp \
            osc/sonic_pi_tcp_osc_server.cpp \
+           osc/udppacketring.cpp \
+           osc/oscmessagequeue.cpp \
+           osc/cuefloodcontrol.cpp \
            widgets/sonicpilog.cpp \
            widgets/infowidget.cpp \
            widgets/sonicpiscintilla.cpp \
            widgets/sonicpilexer.cpp \
            widgets/settingswidget.cpp \
            model/sonicpitheme.cpp \
-           visualizer/scope.cpp
+           model/cuemonitormodel.cpp \
+           visualizer/scope.cpp \
+           visualizer/scopehistory.cpp \
+           visualizer/dspkernels.cpp \
+           visualizer/fft.cpp \
+           visualizer/scopecanvas.cpp \
+           visualizer/levelanalyser.cpp \
+           visualizer/levelmeter.cpp \
+           visualizer/controlbusmonitor.cpp
 
 HEADERS  += mainwindow.h \
             widgets/sonicpilog.h \
@@ -80,6 +95,10 @@ HEADERS  += mainwindow.h \
             widgets/sonicpiscintilla.h \
             widgets/settingswidget.h \
             utils/sonicpiapis.h \
+            utils/fuzzymatcher.h \
+            utils/rubyindenter.h \
+            utils/rubyblockindex.h \
+            utils/linediff.h \
             utils/ruby_help.h \
             osc/oscpkt.hh \
             osc/udp.hh \
@@ -88,9 +107,21 @@ HEADERS  += mainwindow.h \
             osc/sonic_pi_osc_server.h \
             osc/sonic_pi_udp_osc_server.h \
             osc/sonic_pi_tcp_osc_server.h \
+            osc/udppacketring.h \
+            osc/oscmessagequeue.h \
+            osc/cuefloodcontrol.h \
             model/sonicpitheme.h \
             model/settings.h \
-            visualizer/scope.h
+            model/cuemonitormodel.h \
+            visualizer/scope.h \
+            visualizer/scopehistory.h \
+            visualizer/dspkernels.h \
+            visualizer/fft.h \
+            visualizer/triplebuffer.h \
+            visualizer/scopecanvas.h \
+            visualizer/levelanalyser.h \
+            visualizer/levelmeter.h \
+            visualizer/controlbusmonitor.h
 
 TRANSLATIONS = lang/sonic-pi_bg.ts \
     lang/sonic-pi_bs.ts \
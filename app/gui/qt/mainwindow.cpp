@@ -41,6 +41,8 @@
 #include <QBoxLayout>
 #include <QLabel>
 #include <QLineEdit>
+#include <QTableView>
+#include <QHeaderView>
 
 // QScintilla stuff
 #include <Qsci/qsciapis.h>
@@ -63,6 +65,7 @@
 #include "widgets/sonicpilog.h"
 #include "widgets/infowidget.h"
 #include "model/settings.h"
+#include "model/cuemonitormodel.h"
 #include "widgets/settingswidget.h"
 
 #include "utils/ruby_help.h"
@@ -184,14 +187,20 @@ MainWindow::MainWindow(QApplication &app, bool i18n, QSplashScreen* splash)
     //setup autocompletion
     autocomplete->loadSamples(sample_path);
 
-    OscHandler* handler = new OscHandler(this, outputPane, incomingPane, theme);
+    oscHandler = new OscHandler(this, outputPane, incomingPane, cueMonitor, theme);
+
+    // flooding cue paths are summarised on a timer so the summaries
+    // still arrive once the cues stop, whichever transport is in use
+    QTimer *cueSummaryTimer = new QTimer(this);
+    connect(cueSummaryTimer, SIGNAL(timeout()), this, SLOT(collectCueSummaries()));
+    cueSummaryTimer->start(250);
 
     if(protocol == UDP){
-        sonicPiOSCServer = new SonicPiUDPOSCServer(this, handler, gui_listen_to_server_port);
+        sonicPiOSCServer = new SonicPiUDPOSCServer(this, oscHandler, gui_listen_to_server_port);
         osc_thread = QtConcurrent::run(sonicPiOSCServer, &SonicPiOSCServer::start);
     }
     else{
-        sonicPiOSCServer = new SonicPiTCPOSCServer(this, handler);
+        sonicPiOSCServer = new SonicPiTCPOSCServer(this, oscHandler, gui_listen_to_server_port);
         sonicPiOSCServer->start();
     }
 
@@ -220,10 +229,14 @@ MainWindow::MainWindow(QApplication &app, bool i18n, QSplashScreen* splash)
         // We have a connection! Finish up loading app...
         scopeInterface->scsynthBooted();
         updateColourTheme();
+        // the event loop is about to run, so small messages can now be
+        // batched into bundles
+        oscSender->setCoalescing(true);
         std::cout << "[GUI] - load workspaces" << std::endl;
         loadWorkspaces();
         std::cout << "[GUI] - load request Version" << std::endl;
         requestVersion();
+        requestScsynthInfo();
         changeSystemPreAmp(piSettings->main_volume, 1);
 
         QTimer *timer = new QTimer(this);
@@ -515,10 +528,12 @@ void MainWindow::setupWindowStructure() {
     connect(settingsWidget, SIGNAL(showFullscreenChanged()), this, SLOT(updateFullScreenMode()));
     connect(settingsWidget, SIGNAL(showTabsChanged()), this, SLOT(updateTabsVisibility()));
     connect(settingsWidget, SIGNAL(logAutoScrollChanged()), this, SLOT(updateLogAutoScroll()));
+    connect(settingsWidget, SIGNAL(cueFloodChanged()), this, SLOT(updateCueFloodControl()));
     connect(settingsWidget, SIGNAL(themeChanged()), this, SLOT(updateColourTheme()));
     connect(settingsWidget, SIGNAL(scopeChanged()), this, SLOT(scope()));
     connect(settingsWidget, SIGNAL(scopeChanged(QString)), this, SLOT(toggleScope(QString)));
     connect(settingsWidget, SIGNAL(scopeAxesChanged()), this, SLOT(toggleScopeAxes()));
+    connect(settingsWidget, SIGNAL(scopeRendererChanged()), this, SLOT(toggleScopeRenderer()));
     connect(settingsWidget, SIGNAL(transparencyChanged(int)), this, SLOT(changeGUITransparency(int)));
 
     connect(settingsWidget, SIGNAL(checkUpdatesChanged()), this, SLOT(update_check_updates()));
@@ -699,8 +714,13 @@ void MainWindow::setupWindowStructure() {
         incomingPane->setFontFamily(theme->font("LogFace"));
     }
 
-    outputPane->document()->setMaximumBlockCount(1000);
-    incomingPane->document()->setMaximumBlockCount(1000);
+    // the log panes trim themselves, spilling old lines to disk
+    outputPane->setMaxLines(1000);
+    incomingPane->setMaxLines(1000);
+    if(homeDirWritable) {
+        outputPane->setHistoryFile(QDir::toNativeSeparators(log_path + "/output-history.log"));
+        incomingPane->setHistoryFile(QDir::toNativeSeparators(log_path + "/cues-history.log"));
+    }
     errorPane->document()->setMaximumBlockCount(1000);
 
     outputPane->setTextColor(QColor(theme->color("LogForeground")));
@@ -746,10 +766,29 @@ void MainWindow::setupWindowStructure() {
     incomingWidget->setAllowedAreas(Qt::RightDockWidgetArea);
     incomingWidget->setWidget(incomingPane);
 
+    cueMonitor = new CueMonitorModel(this);
+    connect(cueMonitor, SIGNAL(cuePathAdded(QString, QString)), this, SLOT(addCuePath(QString, QString)));
+    cueMonitorView = new QTableView;
+    cueMonitorView->setModel(cueMonitor);
+    cueMonitorView->setFocusPolicy(Qt::NoFocus);
+    cueMonitorView->setSelectionMode(QAbstractItemView::NoSelection);
+    cueMonitorView->setWordWrap(false);
+    cueMonitorView->verticalHeader()->hide();
+    cueMonitorView->horizontalHeader()->setStretchLastSection(true);
+
+    cueMonitorWidget = new QDockWidget(tr("Cue Monitor"), this);
+    cueMonitorWidget->setFocusPolicy(Qt::NoFocus);
+    cueMonitorWidget->setFeatures(QDockWidget::NoDockWidgetFeatures);
+    cueMonitorWidget->setAllowedAreas(Qt::RightDockWidgetArea);
+    cueMonitorWidget->setWidget(cueMonitorView);
+
     addDockWidget(Qt::RightDockWidgetArea, outputWidget);
     addDockWidget(Qt::RightDockWidgetArea, incomingWidget);
+    tabifyDockWidget(incomingWidget, cueMonitorWidget);
+    incomingWidget->raise();
     outputWidget->setObjectName("output");
     incomingWidget->setObjectName("input");
+    cueMonitorWidget->setObjectName("cue-monitor");
 
     blankWidget = new QWidget();
     outputWidgetTitle = outputWidget->titleBarWidget();
@@ -914,8 +953,10 @@ void MainWindow::updateLogVisibility(){
 void MainWindow::updateIncomingOscLogVisibility(){
     if(piSettings->show_incoming_osc_log) {
         incomingWidget->show();
+        cueMonitorWidget->show();
     } else{
         incomingWidget->close();
+        cueMonitorWidget->close();
     }
 }
 
@@ -1201,8 +1242,10 @@ bool isScopeEnabled( const QSettings& settings, const QString& name )
 void MainWindow::honourPrefs() {
     update_check_updates();
     updateLogAutoScroll();
+    updateCueFloodControl();
     changeGUITransparency(piSettings->gui_transparency);
     toggleScopeAxes();
+    toggleScopeRenderer();
     toggleMidi(1);
     toggleOSCServer(1);
     toggleIcons();
@@ -1761,6 +1804,11 @@ void MainWindow::toggleScopeAxes()
     scopeInterface->setScopeAxes(piSettings->show_scope_axes);
 }
 
+void MainWindow::toggleScopeRenderer()
+{
+    scopeInterface->setDirectRendering(piSettings->scope_direct_render);
+}
+
 void MainWindow::cycleThemes() {
     if ( piSettings->theme == SonicPiTheme::LightMode ) { 
         piSettings->theme = SonicPiTheme::DarkMode;
@@ -1786,6 +1834,14 @@ void MainWindow::updateLogAutoScroll() {
     }
 }
 
+void MainWindow::updateCueFloodControl() {
+    oscHandler->setCueFloodLimits(piSettings->cue_flood_rate, piSettings->cue_flood_burst);
+}
+
+void MainWindow::collectCueSummaries() {
+    oscHandler->collectCueSummaries();
+}
+
 void MainWindow::toggleIcons() {
     runAct->setIcon(theme->getRunIcon());
     stopAct->setIcon(theme->getStopIcon());
@@ -1869,6 +1925,8 @@ void MainWindow::updateColourTheme(){
     }
 
     scopeInterface->setColor(theme->color("Scope"));
+    outputPane->updateTheme(theme);
+    incomingPane->updateTheme(theme);
     lexer->unhighlightAll();
 }
 
@@ -2334,6 +2392,8 @@ void MainWindow::readSettings() {
     piSettings->clear_output_on_run = settings.value("prefs/clear-output-on-run", true).toBool();
     piSettings->log_cues = settings.value("prefs/log-cues", false).toBool();
     piSettings->log_auto_scroll = settings.value("prefs/log-auto-scroll", true).toBool();
+    piSettings->cue_flood_rate = settings.value("prefs/cue-flood-rate", 20).toInt();
+    piSettings->cue_flood_burst = settings.value("prefs/cue-flood-burst", 40).toInt();
     piSettings->show_line_numbers =  settings.value("prefs/show-line-numbers", true).toBool();
     piSettings->enable_external_synths = settings.value("prefs/enable-external-synths", false).toBool();
     piSettings->synth_trigger_timing_guarantees = settings.value("prefs/synth-trigger-timing-guarantees", false).toBool();
@@ -2346,6 +2406,7 @@ void MainWindow::readSettings() {
     piSettings->gui_transparency = settings.value("prefs/gui_transparency", 0).toInt();
     piSettings->show_scopes = settings.value("prefs/scope/show-scopes", true).toBool();
     piSettings->show_scope_axes = settings.value("prefs/scope/show-axes", false).toBool();
+    piSettings->scope_direct_render = settings.value("prefs/scope/direct-render", false).toBool();
     piSettings->show_incoming_osc_log = settings.value("prefs/show_incoming_osc_log", true).toBool();
 
     emit settingsChanged();
@@ -2379,6 +2440,8 @@ void MainWindow::writeSettings()
     settings.setValue("prefs/clear-output-on-run", piSettings->clear_output_on_run);
     settings.setValue("prefs/log-cues", piSettings->log_cues);
     settings.setValue("prefs/log-auto-scroll", piSettings->log_auto_scroll);
+    settings.setValue("prefs/cue-flood-rate", piSettings->cue_flood_rate);
+    settings.setValue("prefs/cue-flood-burst", piSettings->cue_flood_burst);
     settings.setValue("prefs/show-line-numbers", piSettings->show_line_numbers);
     settings.setValue("prefs/enable-external-synths", piSettings->enable_external_synths);
     settings.setValue("prefs/synth-trigger-timing-guarantees", piSettings->synth_trigger_timing_guarantees);
@@ -2389,6 +2452,7 @@ void MainWindow::writeSettings()
     settings.setValue("prefs/auto-indent-on-run", piSettings->auto_indent_on_run);
     settings.setValue("prefs/gui_transparency", piSettings->gui_transparency);
     settings.setValue("prefs/scope/show-axes", piSettings->show_scope_axes );
+    settings.setValue("prefs/scope/direct-render", piSettings->scope_direct_render );
     settings.setValue("prefs/scope/show-scopes", piSettings->show_scopes );
     settings.setValue("prefs/show_incoming_osc_log", piSettings->show_incoming_osc_log);
 
@@ -2483,12 +2547,16 @@ void MainWindow::onExitCleanup()
             // this should be a synchorous call to avoid the following sleep
             saveWorkspaces();
         }
+        // no event loop from here on, so send everything straight away
+        oscSender->setCoalescing(false);
         sleep(1);
         std::cout << "[GUI] - asking server process to exit..." << std::endl;
         Message msg("/exit");
         msg.pushStr(guiID.toStdString());
         sendOSC(msg);
     }
+    std::cout << "[GUI] - sent " << oscSender->messageCount() << " OSC messages in " << oscSender->packetCount() << " packets" << std::endl;
+    std::cout << "[GUI] - log updates merged per frame (max): output " << outputPane->maxFlushMerged() << ", cues " << incomingPane->maxFlushMerged() << std::endl;
     if(protocol == UDP){
         osc_thread.waitForFinished();
     }
@@ -2662,6 +2730,17 @@ void MainWindow::requestVersion() {
     sendOSC(msg);
 }
 
+void MainWindow::requestScsynthInfo() {
+    Message msg("/scsynth-info");
+    msg.pushStr(guiID.toStdString());
+    sendOSC(msg);
+}
+
+void MainWindow::setScsynthSampleRate(double rate) {
+    std::cout << "[GUI] - scsynth sample rate: " << rate << std::endl;
+    scopeInterface->setSampleRate(rate);
+}
+
 void MainWindow::updateVersionNumber(QString v, int v_num,QString latest_v, int latest_v_num, QDate last_checked, QString platform) {
     version = v;
     version_num = v_num;
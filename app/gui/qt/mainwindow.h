@@ -54,9 +54,12 @@ class SonicPiAPIs;
 class SonicPiLog;
 class SonicPiScintilla;
 class SonicPiOSCServer;
+class OscHandler;
 class SonicPiTheme;
 class SonicPiLexer;
 class SonicPiSettings;
+class CueMonitorModel;
+class QTableView;
 
 struct help_page {
     QString title;
@@ -81,6 +84,7 @@ class MainWindow : public QMainWindow
 #endif
 
         SonicPiOSCServer *sonicPiOSCServer;
+        OscHandler *oscHandler;
         enum {UDP=0, TCP=1};
         bool loaded_workspaces;
         QString hash_salt;
@@ -102,6 +106,8 @@ signals:
         void zoomOutLogs();
         QString sonicPiHomePath();
         void updateLogAutoScroll();
+        void updateCueFloodControl();
+        void collectCueSummaries();
         bool eventFilter(QObject *obj, QEvent *evt);
         void changeTab(int id);
         QString asciiArtLogo();
@@ -148,6 +154,7 @@ signals:
         void toggleLeftScope();
         void toggleRightScope();
         void toggleScopeAxes();
+        void toggleScopeRenderer();
         void scopeVisibilityChanged();
         void cycleThemes();
         void updateColourTheme();
@@ -186,6 +193,8 @@ signals:
         void setUpdateInfoText(QString t);
         void updateVersionNumber(QString version, int version_num, QString latest_version, int latest_version_num, QDate last_checked_date, QString platform);
         void requestVersion();
+        void requestScsynthInfo();
+        void setScsynthSampleRate(double rate);
         void heartbeatOSC();
         void zoomCurrentWorkspaceIn();
         void zoomCurrentWorkspaceOut();
@@ -282,9 +291,12 @@ signals:
         QTabWidget *docsCentral;
         SonicPiLog *outputPane;
         SonicPiLog *incomingPane;
+        CueMonitorModel *cueMonitor;
+        QTableView *cueMonitorView;
         QTextBrowser *errorPane;
         QDockWidget *outputWidget;
         QDockWidget *incomingWidget;
+        QDockWidget *cueMonitorWidget;
         QDockWidget *prefsWidget;
         QDockWidget *hudWidget;
         QDockWidget *docWidget;
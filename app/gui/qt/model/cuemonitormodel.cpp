@@ -0,0 +1,189 @@
+//--
+// This file is part of Sonic Pi: http://sonic-pi.net
+// Full project source: https://github.com/samaaron/sonic-pi
+// License: https://github.com/samaaron/sonic-pi/blob/master/LICENSE.md
+//
+// Copyright 2013, 2014, 2015, 2016 by Sam Aaron (http://sam.aaron.name).
+// All rights reserved.
+//
+// Permission is granted for use, copying, modification, and
+// distribution of modified versions of this work as long as this
+// notice is included.
+//++
+
+
+#include "cuemonitormodel.h"
+
+#include <QTimer>
+#include <QMutexLocker>
+#include <cmath>
+
+// time constant of the smoothed rate, in seconds
+static const double RATE_TAU = 2.0;
+
+CueMonitorModel::CueMonitorModel(QObject *parent) : QAbstractTableModel(parent)
+{
+  merge_pending = false;
+
+  mergeTimer = new QTimer(this);
+  mergeTimer->setSingleShot(true);
+  mergeTimer->setInterval(16);
+  connect(mergeTimer, SIGNAL(timeout()), this, SLOT(mergePending()));
+
+  rateTimer = new QTimer(this);
+  rateTimer->setInterval(250);
+  connect(rateTimer, SIGNAL(timeout()), this, SLOT(updateRates()));
+  rate_clock.start();
+}
+
+void CueMonitorModel::recordCue(const QString &path, const QString &args)
+{
+  {
+    QMutexLocker locker(&pending_mutex);
+    PendingCue &cue = pending[path];
+    cue.args = args;
+    cue.hits++;
+    cue.last_seen = QTime::currentTime();
+  }
+
+  if(!merge_pending.exchange(true)) {
+    QMetaObject::invokeMethod(this, "scheduleMerge", Qt::QueuedConnection);
+  }
+}
+
+void CueMonitorModel::scheduleMerge()
+{
+  if(!mergeTimer->isActive()) {
+    mergeTimer->start();
+  }
+}
+
+void CueMonitorModel::mergePending()
+{
+  merge_pending = false;
+
+  QHash<QString, PendingCue> merged;
+  {
+    QMutexLocker locker(&pending_mutex);
+    merged.swap(pending);
+  }
+
+  for(QHash<QString, PendingCue>::const_iterator it = merged.constBegin(); it != merged.constEnd(); ++it) {
+    int row = row_index.value(it.key(), -1);
+    if(row == -1) {
+      row = rows.size();
+      beginInsertRows(QModelIndex(), row, row);
+      CueRow cue_row;
+      cue_row.path = it.key();
+      cue_row.hits = 0;
+      cue_row.tick_hits = 0;
+      cue_row.rate = 0;
+      rows.append(cue_row);
+      row_index.insert(it.key(), row);
+      endInsertRows();
+      emit cuePathAdded(it.key(), it.value().args);
+    }
+
+    CueRow &cue_row = rows[row];
+    cue_row.args = it.value().args;
+    cue_row.hits += it.value().hits;
+    cue_row.tick_hits += it.value().hits;
+    cue_row.last_seen = it.value().last_seen;
+    active_rows.insert(row);
+    emit dataChanged(index(row, ValueColumn), index(row, LastSeenColumn));
+  }
+
+  if(!rateTimer->isActive() && !active_rows.isEmpty()) {
+    rate_clock.restart();
+    rateTimer->start();
+  }
+}
+
+void CueMonitorModel::updateRates()
+{
+  double dt = rate_clock.restart() / 1000.0;
+  if(dt <= 0) {
+    return;
+  }
+  double alpha = 1.0 - std::exp(-dt / RATE_TAU);
+
+  QSet<int>::iterator it = active_rows.begin();
+  while(it != active_rows.end()) {
+    CueRow &cue_row = rows[*it];
+    double instant = cue_row.tick_hits / dt;
+    cue_row.rate += alpha * (instant - cue_row.rate);
+    cue_row.tick_hits = 0;
+    emit dataChanged(index(*it, RateColumn), index(*it, RateColumn));
+
+    // idle rows drop out once their rate has decayed away
+    if(cue_row.rate < 0.05) {
+      cue_row.rate = 0;
+      it = active_rows.erase(it);
+    } else {
+      ++it;
+    }
+  }
+
+  if(active_rows.isEmpty()) {
+    rateTimer->stop();
+  }
+}
+
+int CueMonitorModel::rowCount(const QModelIndex &parent) const
+{
+  return parent.isValid() ? 0 : rows.size();
+}
+
+int CueMonitorModel::columnCount(const QModelIndex &parent) const
+{
+  return parent.isValid() ? 0 : ColumnCount;
+}
+
+QVariant CueMonitorModel::data(const QModelIndex &index, int role) const
+{
+  if(!index.isValid() || index.row() >= rows.size()) {
+    return QVariant();
+  }
+
+  const CueRow &cue_row = rows[index.row()];
+  if(role == Qt::DisplayRole) {
+    switch(index.column()) {
+    case PathColumn:
+      return cue_row.path;
+    case ValueColumn:
+      return cue_row.args;
+    case HitsColumn:
+      return cue_row.hits;
+    case RateColumn:
+      return QString::number(cue_row.rate, 'f', 1);
+    case LastSeenColumn:
+      return cue_row.last_seen.toString("hh:mm:ss.zzz");
+    }
+  } else if(role == Qt::TextAlignmentRole) {
+    if(index.column() == HitsColumn || index.column() == RateColumn) {
+      return int(Qt::AlignRight | Qt::AlignVCenter);
+    }
+  }
+  return QVariant();
+}
+
+QVariant CueMonitorModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+  if(role != Qt::DisplayRole || orientation != Qt::Horizontal) {
+    return QVariant();
+  }
+
+  switch(section) {
+  case PathColumn:
+    return tr("Path");
+  case ValueColumn:
+    return tr("Last value");
+  case HitsColumn:
+    return tr("Hits");
+  case RateColumn:
+    return tr("Rate/s");
+  case LastSeenColumn:
+    return tr("Last seen");
+  }
+  return QVariant();
+}
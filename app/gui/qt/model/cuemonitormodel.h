@@ -0,0 +1,88 @@
+//--
+// This file is part of Sonic Pi: http://sonic-pi.net
+// Full project source: https://github.com/samaaron/sonic-pi
+// License: https://github.com/samaaron/sonic-pi/blob/master/LICENSE.md
+//
+// Copyright 2013, 2014, 2015, 2016 by Sam Aaron (http://sam.aaron.name).
+// All rights reserved.
+//
+// Permission is granted for use, copying, modification, and
+// distribution of modified versions of this work as long as this
+// notice is included.
+//++
+
+#ifndef CUEMONITORMODEL_H
+#define CUEMONITORMODEL_H
+
+#include <QAbstractTableModel>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMutex>
+#include <QSet>
+#include <QTime>
+#include <QVector>
+#include <atomic>
+
+class QTimer;
+
+// One row per cue path with its last value, hit count, smoothed rate
+// and the time it was last seen. Cues are recorded from the OSC thread
+// into a pending table which the GUI thread merges once per frame, so
+// only rows that actually changed are updated however fast cues arrive.
+class CueMonitorModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    enum Column { PathColumn, ValueColumn, HitsColumn, RateColumn, LastSeenColumn, ColumnCount };
+
+    explicit CueMonitorModel(QObject *parent = 0);
+
+    // Thread safe.
+    void recordCue(const QString &path, const QString &args);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const;
+
+signals:
+    void cuePathAdded(QString path, QString val);
+
+private slots:
+    void scheduleMerge();
+    void mergePending();
+    void updateRates();
+
+private:
+    struct PendingCue
+    {
+        PendingCue() : hits(0) {}
+        QString args;
+        quint64 hits;
+        QTime last_seen;
+    };
+
+    struct CueRow
+    {
+        QString path;
+        QString args;
+        quint64 hits;
+        quint64 tick_hits;
+        double rate;
+        QTime last_seen;
+    };
+
+    QMutex pending_mutex;
+    QHash<QString, PendingCue> pending;
+    std::atomic<bool> merge_pending;
+    QTimer *mergeTimer;
+
+    QVector<CueRow> rows;
+    QHash<QString, int> row_index;
+    QSet<int> active_rows;
+    QTimer *rateTimer;
+    QElapsedTimer rate_clock;
+};
+
+#endif // CUEMONITORMODEL_H
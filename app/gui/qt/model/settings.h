@@ -35,6 +35,8 @@ public:
     bool clear_output_on_run;
     bool log_cues;
     bool log_auto_scroll;
+    int cue_flood_rate;
+    int cue_flood_burst;
     int gui_transparency;
     SonicPiTheme::Theme theme;
 
@@ -44,6 +46,7 @@ public:
     // Visualizer
     bool show_scopes;
     bool show_scope_axes;
+    bool scope_direct_render;
     std::vector<QString> scope_names;
     void setScopeState(QString name, bool s) { active_scopes[name] = s; }
     bool isScopeActive(QString name) { return active_scopes[name]; }
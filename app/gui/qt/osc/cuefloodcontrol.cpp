@@ -0,0 +1,126 @@
+//--
+// This file is part of Sonic Pi: http://sonic-pi.net
+// Full project source: https://github.com/samaaron/sonic-pi
+// License: https://github.com/samaaron/sonic-pi/blob/master/LICENSE.md
+//
+// Copyright 2013, 2014, 2015, 2016 by Sam Aaron (http://sam.aaron.name).
+// All rights reserved.
+//
+// Permission is granted for use, copying, modification, and
+// distribution of modified versions of this work as long as this
+// notice is included.
+//++
+
+
+#include "cuefloodcontrol.h"
+#include <algorithm>
+
+CueFloodControl::CueFloodControl()
+{
+  flooding_paths = 0;
+  next_summary_due = 0;
+  next_eviction_due = 0;
+  rate = 20;
+  burst = 40;
+}
+
+void CueFloodControl::setLimits(int rate, int burst)
+{
+  this->rate = std::max(rate, 0);
+  this->burst = std::max(burst, 1);
+}
+
+bool CueFloodControl::admit(const std::string &path, const std::string &args, double now)
+{
+  int r = rate;
+  int b = burst;
+  if (r <= 0 && flooding_paths == 0) {
+    return true;
+  }
+
+  std::unordered_map<std::string, Bucket>::iterator it = buckets.find(path);
+  if (it == buckets.end()) {
+    Bucket bucket;
+    bucket.tokens = b;
+    bucket.last_refill = now;
+    bucket.flooding = false;
+    bucket.suppressed = 0;
+    bucket.window_start = now;
+    it = buckets.insert(std::make_pair(path, bucket)).first;
+  }
+
+  Bucket &bucket = it->second;
+  bucket.tokens = std::min((double)b, bucket.tokens + (now - bucket.last_refill) * r);
+  bucket.last_refill = now;
+
+  if (!bucket.flooding) {
+    if (r <= 0 || bucket.tokens >= 1.0) {
+      bucket.tokens -= 1.0;
+      return true;
+    }
+    bucket.flooding = true;
+    bucket.suppressed = 0;
+    bucket.window_start = now;
+    if (flooding_paths++ == 0) {
+      next_summary_due = now + 1.0;
+    }
+  }
+
+  bucket.suppressed++;
+  bucket.last_args = args;
+  return false;
+}
+
+void CueFloodControl::collectSummaries(double now, std::vector<Summary> &due)
+{
+  int r = rate;
+  if (now >= next_eviction_due) {
+    next_eviction_due = now + 1.0;
+    double refill_time = r > 0 ? (double)burst / r : 0;
+    for (std::unordered_map<std::string, Bucket>::iterator it = buckets.begin(); it != buckets.end();) {
+      if (!it->second.flooding && now - it->second.last_refill >= refill_time) {
+        it = buckets.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+
+  if (flooding_paths == 0 || now < next_summary_due) {
+    return;
+  }
+
+  next_summary_due = now + 1.0;
+  for (std::unordered_map<std::string, Bucket>::iterator it = buckets.begin(); it != buckets.end(); ++it) {
+    Bucket &bucket = it->second;
+    if (!bucket.flooding) {
+      continue;
+    }
+
+    double elapsed = now - bucket.window_start;
+    if (elapsed < 1.0) {
+      next_summary_due = std::min(next_summary_due, bucket.window_start + 1.0);
+      continue;
+    }
+
+    double observed = bucket.suppressed / elapsed;
+    if (bucket.suppressed > 0) {
+      Summary summary;
+      summary.path = it->first;
+      summary.count = bucket.suppressed;
+      summary.rate = observed;
+      summary.last_args = bucket.last_args;
+      due.push_back(summary);
+    }
+
+    // back to normal logging once the path is within its budget again
+    if (r <= 0 || observed <= r) {
+      bucket.flooding = false;
+      bucket.tokens = burst;
+      bucket.last_refill = now;
+      flooding_paths--;
+    }
+    bucket.suppressed = 0;
+    bucket.window_start = now;
+  }
+}
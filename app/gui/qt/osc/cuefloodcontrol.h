@@ -0,0 +1,76 @@
+//--
+// This file is part of Sonic Pi: http://sonic-pi.net
+// Full project source: https://github.com/samaaron/sonic-pi
+// License: https://github.com/samaaron/sonic-pi/blob/master/LICENSE.md
+//
+// Copyright 2013, 2014, 2015, 2016 by Sam Aaron (http://sam.aaron.name).
+// All rights reserved.
+//
+// Permission is granted for use, copying, modification, and
+// distribution of modified versions of this work as long as this
+// notice is included.
+//++
+
+#ifndef CUEFLOODCONTROL_H
+#define CUEFLOODCONTROL_H
+
+#include <atomic>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Per path token buckets deciding which incoming cues get their own
+// line in the cue log. A path that runs out of tokens is considered to
+// be flooding: its lines are dropped and replaced by a summary which is
+// produced at most once a second until the path calms down again.
+//
+// admit() and collectSummaries() must not run concurrently.
+// setLimits() may be called from any thread.
+class CueFloodControl
+{
+
+public:
+    struct Summary
+    {
+        std::string path;
+        unsigned long count;
+        double rate;
+        std::string last_args;
+    };
+
+    CueFloodControl();
+
+    // rate is in lines per second per path, 0 disables flood control
+    void setLimits(int rate, int burst);
+
+    // Returns true if the cue should be logged as a line of its own.
+    bool admit(const std::string &path, const std::string &args, double now);
+
+    // Appends the summaries of flooding paths that are due at now. Also
+    // drops the buckets of quiet paths whose tokens have refilled, as
+    // those would be recreated identically by the next cue.
+    void collectSummaries(double now, std::vector<Summary> &due);
+
+    size_t pathCount() const { return buckets.size(); }
+
+private:
+    struct Bucket
+    {
+        double tokens;
+        double last_refill;
+        bool flooding;
+        unsigned long suppressed;
+        double window_start;
+        std::string last_args;
+    };
+
+    std::unordered_map<std::string, Bucket> buckets;
+    int flooding_paths;
+    double next_summary_due;
+    double next_eviction_due;
+
+    std::atomic<int> rate;
+    std::atomic<int> burst;
+};
+
+#endif // CUEFLOODCONTROL_H
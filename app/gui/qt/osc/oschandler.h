@@ -16,22 +16,79 @@
 
 #include "oscpkt.hh"
 #include "mainwindow.h"
+#include "cuefloodcontrol.h"
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
 class SonicPiTheme;
+class CueMonitorModel;
 
 class OscHandler
 {
 
 public:
-  OscHandler(MainWindow *parent = 0, SonicPiLog *out = 0, SonicPiLog *incoming = 0, SonicPiTheme *theme = 0);
-    void oscMessage(std::vector<char> buffer);
-    bool signal_server_stop;
-    bool server_started;
+  OscHandler(MainWindow *parent = 0, SonicPiLog *out = 0, SonicPiLog *incoming = 0, CueMonitorModel *cueMonitor = 0, SonicPiTheme *theme = 0);
+    // data is only borrowed for the duration of the call
+    void oscMessage(const char *data, size_t size);
+    // for messages that have already been parsed
+    void dispatchMessage(oscpkt::Message *msg);
+    void printRouteStats();
+    // Thread safe. Logs the summaries of flooding cue paths that are
+    // due, and forgets paths that have gone quiet.
+    void collectCueSummaries();
+    void setCueFloodLimits(int rate, int burst);
+    std::atomic<bool> signal_server_stop;
+    std::atomic<bool> server_started;
 
 private:
+    typedef void (OscHandler::*RouteHandler)(oscpkt::Message *msg);
+
+    struct Route
+    {
+        std::string type_tags;
+        RouteHandler handler;
+        unsigned long hits;
+    };
+    typedef std::unordered_map<std::string, Route> RouteTable;
+
+    void addRoute(const std::string &address, const std::string &type_tags, RouteHandler handler);
+    static bool typeTagsMatch(const std::string &expected, const std::string &actual);
+
+    void handleMultiMessage(oscpkt::Message *msg);
+    void handleIncomingOsc(oscpkt::Message *msg);
+    void handleLogInfo(oscpkt::Message *msg);
+    void handleError(oscpkt::Message *msg);
+    void handleSyntaxError(oscpkt::Message *msg);
+    void handleBufferReplace(oscpkt::Message *msg);
+    void handleBufferReplaceIdx(oscpkt::Message *msg);
+    void handleUpdateInfoText(oscpkt::Message *msg);
+    void handleBufferReplaceLines(oscpkt::Message *msg);
+    void handleBufferRunIdx(oscpkt::Message *msg);
+    void handleExited(oscpkt::Message *msg);
+    void handleExitedWithBootError(oscpkt::Message *msg);
+    void handleAck(oscpkt::Message *msg);
+    void handleMidiOutPorts(oscpkt::Message *msg);
+    void handleMidiInPorts(oscpkt::Message *msg);
+    void handleVersion(oscpkt::Message *msg);
+    void handleRunsAllCompleted(oscpkt::Message *msg);
+    void handleScsynthInfo(oscpkt::Message *msg);
+
+    RouteTable routes;
+    unsigned long unhandled_count;
+
+    // cues are admitted on the OSC thread while summaries are collected
+    // on the GUI thread's timer
+    std::mutex cue_flood_mutex;
+    CueFloodControl cue_flood;
+    std::vector<CueFloodControl::Summary> cue_summaries;
+
     SonicPiTheme *theme;
     MainWindow *window;
     SonicPiLog  *out;
     SonicPiLog  *incoming;
+    CueMonitorModel *cueMonitor;
     int last_incoming_path_lens [20];
 
     oscpkt::PacketReader pr;
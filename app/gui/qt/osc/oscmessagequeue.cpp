@@ -0,0 +1,84 @@
+//--
+// This file is part of Sonic Pi: http://sonic-pi.net
+// Full project source: https://github.com/samaaron/sonic-pi
+// License: https://github.com/samaaron/sonic-pi/blob/master/LICENSE.md
+//
+// Copyright 2013, 2014, 2015, 2016 by Sam Aaron (http://sam.aaron.name).
+// All rights reserved.
+//
+// Permission is granted for use, copying, modification, and
+// distribution of modified versions of this work as long as this
+// notice is included.
+//++
+
+
+#include "oscmessagequeue.h"
+#include <chrono>
+
+OscMessageQueue::OscMessageQueue(size_t capacity)
+{
+  size_t size = 1;
+  while (size < capacity) {
+    size <<= 1;
+  }
+  slots.resize(size);
+  mask = size - 1;
+  head = 0;
+  tail = 0;
+  high_water = 0;
+  consumer_waiting = false;
+}
+
+oscpkt::Message *OscMessageQueue::beginPush()
+{
+  size_t h = head.load(std::memory_order_relaxed);
+  if (h - tail.load(std::memory_order_acquire) == slots.size()) {
+    return 0;
+  }
+  return &slots[h & mask];
+}
+
+void OscMessageQueue::commitPush()
+{
+  size_t h = head.load(std::memory_order_relaxed) + 1;
+  head.store(h, std::memory_order_seq_cst);
+
+  size_t d = h - tail.load(std::memory_order_relaxed);
+  if (d > high_water.load(std::memory_order_relaxed)) {
+    high_water.store(d, std::memory_order_relaxed);
+  }
+
+  if (consumer_waiting.load(std::memory_order_seq_cst)) {
+    std::lock_guard<std::mutex> lock(wait_mutex);
+    wait_cond.notify_one();
+  }
+}
+
+oscpkt::Message *OscMessageQueue::front()
+{
+  size_t t = tail.load(std::memory_order_relaxed);
+  if (t == head.load(std::memory_order_acquire)) {
+    return 0;
+  }
+  return &slots[t & mask];
+}
+
+void OscMessageQueue::pop()
+{
+  tail.store(tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+void OscMessageQueue::waitForMessage(int timeout_ms)
+{
+  std::unique_lock<std::mutex> lock(wait_mutex);
+  consumer_waiting.store(true, std::memory_order_seq_cst);
+  if (tail.load(std::memory_order_relaxed) == head.load(std::memory_order_seq_cst)) {
+    wait_cond.wait_for(lock, std::chrono::milliseconds(timeout_ms));
+  }
+  consumer_waiting.store(false, std::memory_order_relaxed);
+}
+
+size_t OscMessageQueue::depth() const
+{
+  return head.load(std::memory_order_relaxed) - tail.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,64 @@
+//--
+// This file is part of Sonic Pi: http://sonic-pi.net
+// Full project source: https://github.com/samaaron/sonic-pi
+// License: https://github.com/samaaron/sonic-pi/blob/master/LICENSE.md
+//
+// Copyright 2013, 2014, 2015, 2016 by Sam Aaron (http://sam.aaron.name).
+// All rights reserved.
+//
+// Permission is granted for use, copying, modification, and
+// distribution of modified versions of this work as long as this
+// notice is included.
+//++
+
+#ifndef OSCMESSAGEQUEUE_H
+#define OSCMESSAGEQUEUE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+#include "oscpkt.hh"
+
+// Single producer, single consumer ring of parsed OSC messages. The
+// slots are allocated up front and filled by swapping a parsed message
+// in, so message buffers circulate between the reader and the queue
+// instead of being copied or reallocated.
+class OscMessageQueue
+{
+
+public:
+    // capacity is rounded up to a power of two
+    OscMessageQueue(size_t capacity = 512);
+
+    // Producer side. Returns the next free slot, or 0 if the queue is
+    // full. The slot is published by commitPush().
+    oscpkt::Message *beginPush();
+    void commitPush();
+
+    // Consumer side. Returns the oldest message, or 0 if empty. The
+    // slot is released back to the producer by pop().
+    oscpkt::Message *front();
+    void pop();
+
+    // Consumer side. Blocks until a message is pushed or timeout_ms
+    // passes. Producers only touch the mutex if the consumer is asleep.
+    void waitForMessage(int timeout_ms);
+
+    size_t depth() const;
+    size_t highWaterMark() const { return high_water; }
+    size_t capacity() const { return slots.size(); }
+
+private:
+    std::vector<oscpkt::Message> slots;
+    size_t mask;
+    std::atomic<size_t> head;
+    std::atomic<size_t> tail;
+    std::atomic<size_t> high_water;
+
+    std::atomic<bool> consumer_waiting;
+    std::mutex wait_mutex;
+    std::condition_variable wait_cond;
+};
+
+#endif // OSCMESSAGEQUEUE_H
@@ -361,9 +361,12 @@ public:
   }
   ArgReader arg() const { return ArgReader(*this, OK_NO_ERROR); }
 
-  /** build the osc message for raw data (the message will keep a copy of that data) */
-  void buildFromRawData(const void *ptr, size_t sz) {
+  /** build the osc message for raw data (the message will keep a copy of that data)
+      Modified from original: takes the time tag so that PacketReader can refill
+      messages in place and reuse their storage */
+  void buildFromRawData(const void *ptr, size_t sz, TimeTag tt = TimeTag::immediate()) {
     clear();
+    time_tag = tt;
     storage.assign((const char*)ptr, (const char*)ptr + sz);
     const char *address_beg = storage.begin();
     const char *address_end = (const char*)memchr(address_beg, 0, storage.end()-address_beg);
@@ -506,29 +509,31 @@ private:
 */
 class PacketReader {
 public:
-  PacketReader() { err = OK_NO_ERROR; }
+  PacketReader() { err = OK_NO_ERROR; num_messages = 0; it_messages = 0; }
   /** pointer and size of the osc packet to be parsed. */
   PacketReader(const void *ptr, size_t sz) { init(ptr, sz); }
 
   void init(const void *ptr, size_t sz) {
-    err = OK_NO_ERROR; messages.clear();
+    err = OK_NO_ERROR; num_messages = 0; it_messages = 0;
     if ((sz%4) == 0) { 
       parse((const char*)ptr, (const char *)ptr+sz, TimeTag::immediate());
     } else OSCPKT_SET_ERR(INVALID_PACKET_SIZE);
-    it_messages = messages.begin();
   }
   
   /** extract the next osc message from the packet. return 0 when all messages have been read, or in case of error. */
   Message *popMessage() {
-    if (!err && !messages.empty() && it_messages != messages.end()) return &*it_messages++;
+    if (!err && it_messages < num_messages) return &messages[it_messages++];
     else return 0;
   }
   bool isOk() const { return err == OK_NO_ERROR; }
   ErrorCode getErr() const { return err; }
 
 private:
-  std::list<Message> messages;
-  std::list<Message>::iterator it_messages;
+  /* Modified from original: messages are kept between packets and rebuilt
+     in place, so a steady stream of packets does not allocate */
+  std::vector<Message> messages;
+  size_t num_messages;
+  size_t it_messages;
   ErrorCode err;
   
   void parse(const char *beg, const char *end, TimeTag time_tag) {
@@ -554,8 +559,10 @@ private:
         OSCPKT_SET_ERR(INVALID_BUNDLE);
       }
     } else {
-      messages.push_back(Message(beg, end-beg, time_tag));
-      if (!messages.back().isOk()) OSCPKT_SET_ERR(messages.back().getErr());
+      if (num_messages == messages.size()) messages.push_back(Message());
+      Message &msg = messages[num_messages++];
+      msg.buildFromRawData(beg, end-beg, time_tag);
+      if (!msg.isOk()) OSCPKT_SET_ERR(msg.getErr());
     }
   }
 };
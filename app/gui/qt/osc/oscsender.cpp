@@ -19,33 +19,111 @@
 #include "oscsender.h"
 using namespace oscpkt;
 
-OscSender::OscSender(int port)
+// Stay well below the 16k the server reads per datagram
+static const size_t MAX_BUNDLE_SIZE = 8192;
+
+OscSender::OscSender(int port, QObject *parent) : QObject(parent)
 {
   this->port = port;
+  sock = new UdpSocket();
+  coalescing = false;
+  flush_scheduled = false;
+  pending_size = 0;
+  messages_sent = 0;
+  packets_sent = 0;
+  connectSocket();
 }
 
-bool OscSender::sendOSC(Message m) {
-  UdpSocket sock;
-  sock.connectTo("127.0.0.1", port);
-  if (!sock.isOk()) {
-    std::cerr << "[OSC Sender] - Error connecting to port " << port << ": " << sock.errorMessage() << "\n";
+OscSender::~OscSender()
+{
+  flush();
+  delete sock;
+}
+
+bool OscSender::connectSocket() {
+  sock->connectTo("127.0.0.1", port);
+  if (!sock->isOk()) {
+    std::cerr << "[OSC Sender] - Error connecting to port " << port << ": " << sock->errorMessage() << "\n";
     return false;
-  } else {
-    PacketWriter pw;
-    pw.addMessage(m);
-    return sock.sendPacket(pw.packetData(), pw.packetSize());
   }
+  return true;
+}
+
+bool OscSender::sendPacket(const void *data, size_t size) {
+  if (sock->isOk() && sock->sendPacket(data, size)) {
+    packets_sent++;
+    return true;
+  }
+
+  // the socket may have gone stale (e.g. the server restarted), so
+  // reconnect and retry once
+  if (!connectSocket()) {
+    return false;
+  }
+  if (sock->sendPacket(data, size)) {
+    packets_sent++;
+    return true;
+  }
+  return false;
+}
+
+bool OscSender::sendOSC(Message m) {
+  pw.init();
+  pw.addMessage(m);
+  size_t size = pw.packetSize();
+  messages_sent++;
+
+  if (coalescing && size + 4 + 16 <= MAX_BUNDLE_SIZE) {
+    if (pending_size + size + 4 + 16 > MAX_BUNDLE_SIZE) {
+      flush();
+    }
+    pending.push_back(m);
+    pending_size += size + 4;
+    if (!flush_scheduled) {
+      flush_scheduled = true;
+      QMetaObject::invokeMethod(this, "flush", Qt::QueuedConnection);
+    }
+    return true;
+  }
+
+  // keep ordering: anything queued goes out before this message
+  flush();
+  pw.init();
+  pw.addMessage(m);
+  return sendPacket(pw.packetData(), pw.packetSize());
 }
 
+bool OscSender::flush() {
+  flush_scheduled = false;
+  if (pending.empty()) {
+    return true;
+  }
+
+  pw.init();
+  if (pending.size() == 1) {
+    pw.addMessage(pending[0]);
+  } else {
+    pw.startBundle();
+    for (size_t i = 0; i < pending.size(); i++) {
+      pw.addMessage(pending[i]);
+    }
+    pw.endBundle();
+  }
+  size_t count = pending.size();
+  pending.clear();
+  pending_size = 0;
 
-void OscSender::bufferNewlineAndIndent(int point_line, int point_index, int first_line, std::string code, std::string fileName, std::string id) {
+  if (!sendPacket(pw.packetData(), pw.packetSize())) {
+    std::cout << "[GUI] - Could Not Send OSC (dropped " << count << " batched message(s))" << std::endl;
+    return false;
+  }
+  return true;
+}
 
-  Message msg("/buffer-newline-and-indent");
-  msg.pushStr(id);
-  msg.pushStr(fileName);
-  msg.pushStr(code);
-  msg.pushInt32(point_line);
-  msg.pushInt32(point_index);
-  msg.pushInt32(first_line);
-  sendOSC(msg);
+void OscSender::setCoalescing(bool enabled) {
+  if (!enabled) {
+    flush();
+  }
+  coalescing = enabled;
 }
+
@@ -14,19 +14,52 @@
 #ifndef OSCSENDER_H
 #define OSCSENDER_H
 
+#include <QObject>
+#include <vector>
 #include "oscpkt.hh"
+
+namespace oscpkt {
+  struct UdpSocket;
+}
 using namespace oscpkt;
 
-class OscSender
+class OscSender : public QObject
 {
+    Q_OBJECT
 
 public:
-    OscSender(int port);
+    OscSender(int port, QObject *parent = 0);
+    ~OscSender();
+    // Returns false if a message sent straight away could not be sent.
+    // A queued message always returns true; if its batch fails, flush()
+    // reports it.
     bool sendOSC(Message m);
-    void bufferNewlineAndIndent(int point_line, int point_index, int first_line, std::string code, std::string fileName, std::string id);
+
+    // When coalescing, small messages sent within one event loop
+    // iteration go out together as a single #bundle. Turning it off
+    // flushes anything still queued.
+    void setCoalescing(bool enabled);
+
+    unsigned long messageCount() const { return messages_sent; }
+    unsigned long packetCount() const { return packets_sent; }
+
+public slots:
+    bool flush();
 
 private:
+    bool connectSocket();
+    bool sendPacket(const void *data, size_t size);
+
     int port;
+    UdpSocket *sock;
+    bool coalescing;
+    bool flush_scheduled;
+    std::vector<Message> pending;
+    size_t pending_size;
+    PacketWriter pw;
+
+    unsigned long messages_sent;
+    unsigned long packets_sent;
 };
 
 #endif // OSCSENDER_H
@@ -15,6 +15,7 @@
 #define SONICPIOSCSERVER_H
 
 #include <QObject>
+#include <atomic>
 #include "oschandler.h"
 
 class SonicPiOSCServer : public QObject
@@ -36,8 +37,8 @@ public slots:
 protected:
     OscHandler* handler;
     MainWindow* parent;
-    bool osc_incoming_port_open;
-    bool stop_server;
+    std::atomic<bool> osc_incoming_port_open;
+    std::atomic<bool> stop_server;
     int port_num;
     bool continueListening();
 
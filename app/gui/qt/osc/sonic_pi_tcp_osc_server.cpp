@@ -4,26 +4,31 @@
 // Qt stuff
 #include <QtNetwork>
 #include <QTcpSocket>
+#include <QtEndian>
 
+#include <cstring>
 #include <iostream>
 #include "sonic_pi_osc_server.h"
 
 // OSC stuff
 #include "oscpkt.hh"
 
-SonicPiTCPOSCServer::SonicPiTCPOSCServer(MainWindow *sonicPiWindow, OscHandler *oscHandler) : SonicPiOSCServer(sonicPiWindow, oscHandler)
+SonicPiTCPOSCServer::SonicPiTCPOSCServer(MainWindow *sonicPiWindow, OscHandler *oscHandler, int port) : SonicPiOSCServer(sonicPiWindow, oscHandler)
 {
     tcpServer = new QTcpServer(sonicPiWindow);
-    buffer.clear();
-    blockSize = 0;
+    port_num = port;
 
     connect(tcpServer, SIGNAL(newConnection()), this, SLOT(client()));
 }
 
+SonicPiTCPOSCServer::~SonicPiTCPOSCServer()
+{
+    qDeleteAll(clients);
+}
+
 void SonicPiTCPOSCServer::start(){
-    int PORT_NUM = 4558;
-    if(tcpServer->listen(QHostAddress::LocalHost, PORT_NUM)){
-      std::cout << "[GUI] - TCP OSC Server started: " << PORT_NUM << std::endl;
+    if(tcpServer->listen(QHostAddress::LocalHost, port_num)){
+      std::cout << "[GUI] - TCP OSC Server started: " << port_num << std::endl;
       handler->server_started = true;
     }
     else{
@@ -35,6 +40,7 @@ void SonicPiTCPOSCServer::start(){
 
 void SonicPiTCPOSCServer::stop(){
     tcpServer->close();
+    handler->printRouteStats();
 }
 
 void SonicPiTCPOSCServer::logError(QAbstractSocket::SocketError e){
@@ -45,41 +51,72 @@ void SonicPiTCPOSCServer::client(){
     //In TCP we have no ack signal as we don't block the main loop.
     //Hence assume if we get a connection from a client its booted and ready.
     QMetaObject::invokeMethod(parent, "serverStarted", Qt::QueuedConnection);
-    socket = tcpServer->nextPendingConnection();
-    connect(socket, SIGNAL(readyRead()), this, SLOT(readMessage()));
-    connect(socket, SIGNAL(error(QAbstractSocket::SocketError)), this, SLOT(logError(QAbstractSocket::SocketError)));
-    connect(socket, SIGNAL(disconnected()), socket, SLOT(deleteLater()));
-    std::vector<char>().swap(buffer);
+    while(tcpServer->hasPendingConnections()) {
+        QTcpSocket *socket = tcpServer->nextPendingConnection();
+        ClientState *state = new ClientState;
+        state->buffer.resize(64 * 1024);
+        state->used = 0;
+        clients.insert(socket, state);
+
+        connect(socket, SIGNAL(readyRead()), this, SLOT(readMessage()));
+        connect(socket, SIGNAL(error(QAbstractSocket::SocketError)), this, SLOT(logError(QAbstractSocket::SocketError)));
+        connect(socket, SIGNAL(disconnected()), this, SLOT(clientDisconnected()));
+        std::cout << "[GUI] - TCP OSC client connected (" << clients.size() << " total)" << std::endl;
+    }
+}
+
+void SonicPiTCPOSCServer::clientDisconnected()
+{
+    QTcpSocket *socket = qobject_cast<QTcpSocket*>(sender());
+    if(!socket) {
+        return;
+    }
+    delete clients.take(socket);
+    socket->deleteLater();
+    std::cout << "[GUI] - TCP OSC client disconnected (" << clients.size() << " left)" << std::endl;
 }
 
 void SonicPiTCPOSCServer::readMessage()
 {
-    while(socket->bytesAvailable() > 0){
-        if (blockSize == 0) {
-            if (socket->bytesAvailable() < (int)sizeof(quint32)){
-                return;
-            }
+    QTcpSocket *socket = qobject_cast<QTcpSocket*>(sender());
+    ClientState *state = clients.value(socket);
+    if(!state) {
+        return;
+    }
 
-            socket->read((char *)&blockSize, sizeof(quint32));
-            blockSize = qToBigEndian(blockSize);
+    std::vector<char> &buffer = state->buffer;
+    qint64 available = socket->bytesAvailable();
+    while(available > 0) {
+        if(state->used + available > buffer.size()) {
+            buffer.resize(state->used + available);
         }
 
-        if (socket->bytesAvailable() < blockSize){
+        qint64 bytesRead = socket->read(&buffer[state->used], available);
+        if(bytesRead < 0) {
+            std::cerr << "[GUI] - Error: read: " << bytesRead << "\n";
             return;
         }
+        state->used += bytesRead;
 
-        buffer.resize(blockSize);
-        int bytesRead = socket->read(&buffer[0], blockSize);
+        // hand over every complete frame straight from the buffer
+        size_t pos = 0;
+        while(state->used - pos >= sizeof(quint32)) {
+            quint32 blockSize = qFromBigEndian<quint32>((const uchar *)&buffer[pos]);
+            if(state->used - pos - sizeof(quint32) < blockSize) {
+                break;
+            }
+            handler->oscMessage(&buffer[pos + sizeof(quint32)], blockSize);
+            pos += sizeof(quint32) + blockSize;
+        }
 
-        if(bytesRead < 0 || (uint32_t)bytesRead != blockSize) {
-            std::cerr << "[GUI] - Error: read: " << bytesRead << " Expected:" << blockSize << "\n";
-            blockSize = 0;
-            return;
+        // keep any partial frame at the front for the next read
+        if(pos > 0) {
+            if(state->used > pos) {
+                memmove(&buffer[0], &buffer[pos], state->used - pos);
+            }
+            state->used -= pos;
         }
-        std::vector<char> tmp(buffer);
-        tmp.swap(buffer);
-        handler->oscMessage(buffer);
-        blockSize = 0;
-        std::vector<char>().swap(buffer);
+
+        available = socket->bytesAvailable();
     }
 }
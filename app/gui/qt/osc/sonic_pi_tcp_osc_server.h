@@ -8,29 +8,36 @@
 #include <QtCore>
 #include <QtNetwork>
 #include <QTcpSocket>
+#include <QHash>
 
 class SonicPiTCPOSCServer :  public SonicPiOSCServer
 {
     Q_OBJECT
 
 public:
-    explicit SonicPiTCPOSCServer(MainWindow *parent, OscHandler *handler = 0);
-
-    quint32 blockSize;
+    explicit SonicPiTCPOSCServer(MainWindow *parent, OscHandler *handler = 0, int port = 4558);
+    ~SonicPiTCPOSCServer();
 
 public slots:
     void stop();
     void start();
     void readMessage();
     void client();
+    void clientDisconnected();
     void logError(QAbstractSocket::SocketError);
 
 private:
-    void handleMessage();
+    // Each connection frames its own stream of length prefixed packets.
+    // The buffer only ever grows to the largest frame seen and is
+    // compacted in place, so steady traffic does not reallocate.
+    struct ClientState
+    {
+        std::vector<char> buffer;
+        size_t used;
+    };
 
     QTcpServer *tcpServer;
-    QTcpSocket *socket;
-    std::vector<char> buffer;
+    QHash<QTcpSocket*, ClientState*> clients;
 };
 
 #endif // SONIC_PI_TCP_OSC_SERVER_H
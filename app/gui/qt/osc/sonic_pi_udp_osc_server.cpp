@@ -14,6 +14,11 @@
 #include "sonic_pi_udp_osc_server.h"
 #include "sonic_pi_osc_server.h"
 #include "udp.hh"
+#include "udppacketring.h"
+#include "oscmessagequeue.h"
+
+#include <thread>
+#include <utility>
 
 SonicPiUDPOSCServer::SonicPiUDPOSCServer(MainWindow *sonicPiWindow, OscHandler *oscHandler, int port) : SonicPiOSCServer(sonicPiWindow, oscHandler)
 {
@@ -43,13 +48,64 @@ void SonicPiUDPOSCServer::start(){
 
   osc_incoming_port_open = true;
 
+  // Receiving and parsing happen on this thread. Parsed messages are
+  // handed over to a dispatch thread, which turns them into UI work.
+  UdpPacketRing ring;
+  OscMessageQueue queue;
+  oscpkt::PacketReader pr;
+  receiving = true;
+  std::thread dispatcher(&SonicPiUDPOSCServer::dispatchLoop, this, &queue);
+  size_t dropped = 0;
+
   while (sock.isOk() && continueListening()) {
-    if (sock.receiveNextPacket(30 /* timeout, in ms */)) {
-      handler->oscMessage(sock.buffer);
-      std::vector<char>().swap(sock.buffer);
-      std::cout << std::flush;
+    int count = ring.receive(sock.socketHandle(), 30 /* timeout, in ms */);
+    if (count < 0) {
+      break;
+    }
+    for (int i = 0; i < count; i++) {
+      pr.init(ring.packetData(i), ring.packetSize(i));
+      oscpkt::Message *msg;
+      while (pr.isOk() && (msg = pr.popMessage()) != 0) {
+        oscpkt::Message *slot = queue.beginPush();
+        if (!slot) {
+          // the dispatcher is behind. Stalling here would only move the
+          // loss into the kernel's socket buffer, so drop and count it.
+          dropped++;
+          continue;
+        }
+        // swapping hands the parsed message over without copying and
+        // leaves the slot's old buffers with the reader to parse into
+        std::swap(*slot, *msg);
+        queue.commitPush();
+      }
     }
   }
 
+  receiving = false;
+  dispatcher.join();
+
+  std::cout << "[GUI] - UDP OSC Server received " << ring.packetCount() << " packets in " << ring.syscallCount() << " reads (" << ring.truncatedCount() << " truncated)" << std::endl;
+  std::cout << "[GUI] - UDP OSC Server high-water marks: receive " << ring.highWaterMark() << "/read, dispatch queue " << queue.highWaterMark() << "/" << queue.capacity() << " (" << dropped << " messages dropped)" << std::endl;
+  handler->printRouteStats();
   std::cout << "[GUI] - UDP OSC Server no longer listening" << std::endl << std::flush;
 }
+
+void SonicPiUDPOSCServer::dispatchLoop(OscMessageQueue *queue)
+{
+  while (true) {
+    oscpkt::Message *msg = queue->front();
+    if (msg) {
+      handler->dispatchMessage(msg);
+      queue->pop();
+      continue;
+    }
+
+    if (!receiving) {
+      break;
+    }
+
+    // only pay for the log flush once the queue has drained
+    std::cout << std::flush;
+    queue->waitForMessage(30);
+  }
+}
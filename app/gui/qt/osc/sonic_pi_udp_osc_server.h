@@ -16,6 +16,7 @@
 
 #include "oschandler.h"
 #include "sonic_pi_osc_server.h"
+#include "oscmessagequeue.h"
 #include "mainwindow.h"
 
 class SonicPiUDPOSCServer : public SonicPiOSCServer
@@ -29,6 +30,10 @@ public slots:
     void stop();
     void start();
 
+private:
+    void dispatchLoop(OscMessageQueue *queue);
+
+    std::atomic<bool> receiving;
 };
 
 #endif // SONIC_PI_UDP_OSC_SERVER_H
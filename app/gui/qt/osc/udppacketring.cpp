@@ -0,0 +1,144 @@
+//--
+// This file is part of Sonic Pi: http://sonic-pi.net
+// Full project source: https://github.com/samaaron/sonic-pi
+// License: https://github.com/samaaron/sonic-pi/blob/master/LICENSE.md
+//
+// Copyright 2013, 2014, 2015, 2016 by Sam Aaron (http://sam.aaron.name).
+// All rights reserved.
+//
+// Permission is granted for use, copying, modification, and
+// distribution of modified versions of this work as long as this
+// notice is included.
+//++
+
+
+#include "udppacketring.h"
+
+#include <cstring>
+#include <cerrno>
+#include <iostream>
+
+#if defined(_MSC_VER) || defined(WIN32)
+# include <winsock2.h>
+# include <windows.h>
+#else
+# include <sys/select.h>
+# include <sys/time.h>
+# include <unistd.h>
+#endif
+
+UdpPacketRing::UdpPacketRing(int slots, size_t slot_size) :
+  slots(slots), slot_size(slot_size), storage(slots * slot_size), sizes(slots, 0)
+{
+  packets_received = 0;
+  packets_truncated = 0;
+  syscalls = 0;
+  batch_size = 0;
+  max_batch_size = 0;
+
+#if defined(__linux__)
+  // the headers always point at the same slots, so they are built once
+  headers.resize(slots);
+  iovecs.resize(slots);
+  for (int i = 0; i < slots; i++) {
+    iovecs[i].iov_base = &storage[i * slot_size];
+    iovecs[i].iov_len = slot_size;
+    memset(&headers[i], 0, sizeof(struct mmsghdr));
+    headers[i].msg_hdr.msg_iov = &iovecs[i];
+    headers[i].msg_hdr.msg_iovlen = 1;
+  }
+#endif
+}
+
+int UdpPacketRing::receive(int handle, int timeout_ms)
+{
+  if (handle == -1) {
+    return -1;
+  }
+
+  struct timeval tv;
+  tv.tv_sec = timeout_ms / 1000;
+  tv.tv_usec = (timeout_ms % 1000) * 1000;
+
+  fd_set readset;
+  FD_ZERO(&readset);
+  FD_SET(handle, &readset);
+  batch_size = 0;
+  int ret = select(handle + 1, &readset, 0, 0, &tv);
+  if (ret == 0) { // timeout
+    return 0;
+  }
+  if (ret < 0) {
+#ifdef WIN32
+    int err = WSAGetLastError();
+    if (err == WSAEINTR) {
+      return 0;
+    }
+    std::cout << "[GUI] - UDP select error: system error #" << err << std::endl;
+#else
+    if (errno == EINTR) {
+      return 0;
+    }
+    std::cout << "[GUI] - UDP select error: " << strerror(errno) << std::endl;
+#endif
+    return -1;
+  }
+
+  int count = 0;
+#if defined(__linux__)
+  for (int i = 0; i < slots; i++) {
+    headers[i].msg_hdr.msg_flags = 0;
+  }
+  int nread = recvmmsg(handle, &headers[0], slots, MSG_DONTWAIT, 0);
+  syscalls++;
+  if (nread < 0) {
+    if (errno == EAGAIN || errno == EINTR || errno == EWOULDBLOCK ||
+        errno == ECONNRESET || errno == ECONNREFUSED) {
+      return 0;
+    }
+    std::cout << "[GUI] - UDP receive error: " << strerror(errno) << std::endl;
+    return -1;
+  }
+
+  for (int i = 0; i < nread; i++) {
+    if (headers[i].msg_hdr.msg_flags & MSG_TRUNC) {
+      // too large for a slot, so drop it rather than parse half a packet
+      packets_truncated++;
+      continue;
+    }
+    if (count != i) {
+      memmove(&storage[count * slot_size], &storage[i * slot_size], headers[i].msg_len);
+    }
+    sizes[count++] = headers[i].msg_len;
+  }
+#else
+  int nread = (int)recvfrom(handle, &storage[0], (int)slot_size, 0, 0, 0);
+  syscalls++;
+  if (nread < 0) {
+#ifdef WIN32
+    int err = WSAGetLastError();
+    if (err == WSAEINTR || err == WSAEWOULDBLOCK || err == WSAECONNRESET ||
+        err == WSAECONNREFUSED || err == WSAEMSGSIZE) {
+      if (err == WSAEMSGSIZE) packets_truncated++;
+      return 0;
+    }
+    std::cout << "[GUI] - UDP receive error: system error #" << err << std::endl;
+#else
+    if (errno == EAGAIN || errno == EINTR || errno == EWOULDBLOCK ||
+        errno == ECONNRESET || errno == ECONNREFUSED) {
+      return 0;
+    }
+    std::cout << "[GUI] - UDP receive error: " << strerror(errno) << std::endl;
+#endif
+    return -1;
+  }
+  sizes[count++] = nread;
+#endif
+
+  packets_received += count;
+  batch_size = count;
+  if (count > max_batch_size) {
+    max_batch_size = count;
+  }
+  return count;
+}
@@ -0,0 +1,71 @@
+//--
+// This file is part of Sonic Pi: http://sonic-pi.net
+// Full project source: https://github.com/samaaron/sonic-pi
+// License: https://github.com/samaaron/sonic-pi/blob/master/LICENSE.md
+//
+// Copyright 2013, 2014, 2015, 2016 by Sam Aaron (http://sam.aaron.name).
+// All rights reserved.
+//
+// Permission is granted for use, copying, modification, and
+// distribution of modified versions of this work as long as this
+// notice is included.
+//++
+
+#ifndef UDPPACKETRING_H
+#define UDPPACKETRING_H
+
+#include <vector>
+#include <cstddef>
+#include <stdint.h>
+
+#if defined(__linux__)
+#include <sys/socket.h>
+#include <sys/uio.h>
+#endif
+
+// A fixed set of preallocated datagram slots that are refilled by each
+// call to receive(). On Linux several datagrams are pulled per syscall
+// with recvmmsg, elsewhere one recvfrom is done per call. The packet
+// views stay valid until the next call to receive().
+class UdpPacketRing
+{
+
+public:
+    UdpPacketRing(int slots = 16, size_t slot_size = 65536);
+
+    // Waits up to timeout_ms for data on the bound socket handle and
+    // then reads as many datagrams as there are free slots. Returns the
+    // number of packets received, 0 on timeout or interruption and -1
+    // on a socket error the caller should stop on.
+    int receive(int handle, int timeout_ms);
+
+    const char *packetData(int i) const { return &storage[i * slot_size]; }
+    size_t packetSize(int i) const { return sizes[i]; }
+
+    uint64_t packetCount() const { return packets_received; }
+    uint64_t syscallCount() const { return syscalls; }
+    uint64_t truncatedCount() const { return packets_truncated; }
+
+    // packets waiting in the slots from the last read, and the most a
+    // single read has returned
+    int depth() const { return batch_size; }
+    int highWaterMark() const { return max_batch_size; }
+
+private:
+    int slots;
+    size_t slot_size;
+    std::vector<char> storage;
+    std::vector<size_t> sizes;
+#if defined(__linux__)
+    std::vector<struct mmsghdr> headers;
+    std::vector<struct iovec> iovecs;
+#endif
+
+    uint64_t packets_received;
+    uint64_t packets_truncated;
+    uint64_t syscalls;
+    int batch_size;
+    int max_batch_size;
+};
+
+#endif // UDPPACKETRING_H
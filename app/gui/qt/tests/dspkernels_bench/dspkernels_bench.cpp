@@ -0,0 +1,164 @@
+//--
+// This file is part of Sonic Pi: http://sonic-pi.net
+// Full project source: https://github.com/samaaron/sonic-pi
+// License: https://github.com/samaaron/sonic-pi/blob/master/LICENSE.md
+//
+// Copyright 2013, 2014, 2015, 2016 by Sam Aaron (http://sam.aaron.name).
+// All rights reserved.
+//
+// Permission is granted for use, copying, modification, and
+// distribution of modified versions of this work as long as this
+// notice is included.
+//++
+
+
+// Checks every DspKernels implementation the CPU supports bit for bit
+// against the scalar code on random, unaligned buffers, then reports the
+// throughput of each kernel in millions of samples (or FFT butterflies)
+// per second.
+
+#include "dspkernels.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+static const unsigned int MAX_SAMPLES = 4096;
+static const int ACCURACY_TRIALS = 2000;
+
+struct Buffers
+{
+  std::vector<float> left, right;
+  std::vector<double> out;
+  // butterfly inputs: a, b and twiddles as real and imaginary parts
+  std::vector<double> fft[6];
+  Buffers() : left(MAX_SAMPLES + 8), right(MAX_SAMPLES + 8), out(MAX_SAMPLES + 8)
+  {
+    for( int i = 0; i < 6; ++i ) fft[i].resize(MAX_SAMPLES + 8);
+  }
+};
+
+static void fill( Buffers& b, std::mt19937& rng )
+{
+  std::uniform_real_distribution<float> dist(-1.5f, 1.5f);
+  for( size_t i = 0; i < b.left.size(); ++i )
+  {
+    b.left[i] = dist(rng);
+    b.right[i] = dist(rng);
+    for( int j = 0; j < 6; ++j ) b.fft[j][i] = dist(rng);
+  }
+}
+
+static int countMismatches( const DspKernels& k, Buffers& b, std::mt19937& rng )
+{
+  const DspKernels& ref = DspKernels::scalar();
+  std::vector<double> expected(MAX_SAMPLES + 8);
+  int mismatches = 0;
+  for( int trial = 0; trial < ACCURACY_TRIALS; ++trial )
+  {
+    fill(b, rng);
+    unsigned int offset = rng() % 4;
+    unsigned int n = rng() % (MAX_SAMPLES + 1);
+    const float* l = b.left.data() + offset;
+    const float* r = b.right.data() + offset;
+
+    ref.widen(l, expected.data(), n);
+    k.widen(l, b.out.data(), n);
+    if( memcmp(expected.data(), b.out.data(), n * sizeof(double)) != 0 ) mismatches++;
+
+    ref.monoRms(l, r, expected.data(), n);
+    k.monoRms(l, r, b.out.data(), n);
+    if( memcmp(expected.data(), b.out.data(), n * sizeof(double)) != 0 ) mismatches++;
+
+    if( ref.peak(l, n) != k.peak(l, n) ) mismatches++;
+
+    const double* d = b.fft[0].data() + offset;
+    double ref_min = 0, ref_max = 0, min = 0, max = 0;
+    ref.minMax(d, n, &ref_min, &ref_max);
+    k.minMax(d, n, &min, &max);
+    if( ref_min != min || ref_max != max ) mismatches++;
+
+    std::vector<double> ex[4], ac[4];
+    for( int j = 0; j < 4; ++j )
+    {
+      ex[j].assign(b.fft[j].begin() + offset, b.fft[j].begin() + offset + n);
+      ac[j] = ex[j];
+    }
+    const double* w_re = b.fft[4].data() + offset;
+    const double* w_im = b.fft[5].data() + offset;
+    ref.butterfly(ex[0].data(), ex[1].data(), ex[2].data(), ex[3].data(), w_re, w_im, n);
+    k.butterfly(ac[0].data(), ac[1].data(), ac[2].data(), ac[3].data(), w_re, w_im, n);
+    for( int j = 0; j < 4; ++j )
+    {
+      if( ex[j] != ac[j] )
+      {
+        mismatches++;
+        break;
+      }
+    }
+  }
+  return mismatches;
+}
+
+// Runs fn over the whole buffer until about a fifth of a second has
+// passed and returns millions of samples per second.
+template <typename Fn>
+static double throughput( Fn fn )
+{
+  typedef std::chrono::steady_clock Clock;
+  unsigned long samples = 0;
+  Clock::time_point start = Clock::now();
+  double elapsed = 0;
+  while( elapsed < 0.2 )
+  {
+    for( int i = 0; i < 100; ++i )
+    {
+      fn();
+    }
+    samples += 100 * MAX_SAMPLES;
+    elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+  }
+  return samples / elapsed / 1e6;
+}
+
+static volatile float sink;
+
+int main()
+{
+  std::mt19937 rng(42);
+  Buffers b;
+  fill(b, rng);
+
+  std::vector<DspKernels> kernels = DspKernels::candidates();
+  kernels.push_back(DspKernels::scalar());
+
+  printf("%-8s %10s %10s %10s %10s %10s  %s\n", "kernels", "widen", "monoRms", "peak", "minMax", "butterfly", "vs scalar");
+  int failed = 0;
+  for( const DspKernels& k : kernels )
+  {
+    int mismatches = countMismatches(k, b, rng);
+    failed += mismatches;
+    const float* l = b.left.data();
+    const float* r = b.right.data();
+    double* out = b.out.data();
+    double widen = throughput([&]() { k.widen(l, out, MAX_SAMPLES); });
+    double mono = throughput([&]() { k.monoRms(l, r, out, MAX_SAMPLES); });
+    double peak = throughput([&]() { sink = k.peak(l, MAX_SAMPLES); });
+    double minmax = throughput([&]() { double mn, mx; k.minMax(out, MAX_SAMPLES, &mn, &mx); sink = mn + mx; });
+    // rescale the butterflies each pass so the values stay finite
+    std::vector<double>* f = b.fft;
+    double butterfly = throughput([&]() {
+      k.butterfly(f[0].data(), f[1].data(), f[2].data(), f[3].data(), f[4].data(), f[5].data(), MAX_SAMPLES);
+      k.widen(r, f[0].data(), MAX_SAMPLES);
+      k.widen(l, f[2].data(), MAX_SAMPLES);
+    });
+    printf("%-8s %10.0f %10.0f %10.0f %10.0f %10.0f  %s\n", k.name, widen, mono, peak, minmax, butterfly,
+           mismatches ? "MISMATCH" : "identical");
+  }
+  printf("(millions of samples or butterflies per second, %u per call;\n"
+         " butterfly includes refilling two of its inputs with widen)\n", MAX_SAMPLES);
+  printf("selected: %s\n", DspKernels::get().name);
+  return failed ? 1 : 0;
+}
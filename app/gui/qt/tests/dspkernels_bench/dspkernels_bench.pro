@@ -0,0 +1,27 @@
+#--
+# This file is part of Sonic Pi: http://sonic-pi.net
+# Full project source: https://github.com/samaaron/sonic-pi
+# License: https://github.com/samaaron/sonic-pi/blob/master/LICENSE.md
+#
+# Copyright 2013, 2014, 2015, 2016 by Sam Aaron (http://sam.aaron.name).
+# All rights reserved.
+#
+# Permission is granted for use, copying, modification, distribution,
+# and distribution of modified versions of this work as long as this
+# notice is included.
+#++
+
+# DspKernels check and benchmark, built by ../tests.pro. make check runs
+# it and fails if any kernel's output differs from the scalar code.
+
+TEMPLATE = app
+TARGET = dspkernels_bench
+CONFIG += console c++11 release testcase
+CONFIG -= qt app_bundle
+
+INCLUDEPATH += ../../visualizer
+
+SOURCES += dspkernels_bench.cpp \
+           ../../visualizer/dspkernels.cpp
+
+HEADERS += ../../visualizer/dspkernels.h
@@ -0,0 +1,179 @@
+//--
+// This file is part of Sonic Pi: http://sonic-pi.net
+// Full project source: https://github.com/samaaron/sonic-pi
+// License: https://github.com/samaaron/sonic-pi/blob/master/LICENSE.md
+//
+// Copyright 2013, 2014, 2015, 2016 by Sam Aaron (http://sam.aaron.name).
+// All rights reserved.
+//
+// Permission is granted for use, copying, modification, and
+// distribution of modified versions of this work as long as this
+// notice is included.
+//++
+
+
+// Checks the hunks diffLines gives for a few small edits, then makes
+// random edits to random buffers and checks that the hunks turn one
+// into the other while changing as few lines as a plain longest common
+// subsequence says they must. Finally checks the fallback to a single
+// hunk once the buffers are too far apart.
+
+#include "linediff.h"
+
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+static const int MAX_HUNKS = 4;
+
+struct HunkCase
+{
+  const char *name;
+  const char *from;
+  const char *to;
+  int hunk_count;
+  LineDiffHunk hunks[MAX_HUNKS];
+};
+
+static const HunkCase HUNK_CASES[] = {
+  { "insert", "a\nb\n", "a\nx\ny\nb\n", 1, { { 1, 0, 1, 2 } } },
+  { "delete", "a\nb\nc\nd\n", "a\nd\n", 1, { { 1, 2, 1, 0 } } },
+  { "replace", "a\nb\nc\n", "a\nx\nc\n", 1, { { 1, 1, 1, 1 } } },
+  { "two hunks", "a\nb\nc\nd\ne\n", "a\nx\nc\nd\ny\n", 2, { { 1, 1, 1, 1 }, { 4, 1, 4, 1 } } },
+  { "insert at start", "b\nc\n", "a\nb\nc\n", 1, { { 0, 0, 0, 1 } } },
+  { "delete at end", "a\nb\nc\n", "a\n", 1, { { 1, 2, 1, 0 } } },
+  { "moved line", "a\nb\nc\n", "b\nc\na\n", 2, { { 0, 1, 0, 0 }, { 3, 0, 2, 1 } } },
+  { "all equal", "a\nb\nc\n", "a\nb\nc\n", 0, { { 0, 0, 0, 0 } } },
+  { "both empty", "", "", 0, { { 0, 0, 0, 0 } } },
+  { "from empty", "", "a\nb\n", 1, { { 0, 0, 0, 2 } } },
+  { "to empty", "a\nb\n", "", 1, { { 0, 2, 0, 0 } } },
+  { "newline added at end", "a\nb", "a\nb\n", 1, { { 1, 1, 1, 1 } } },
+  { "line added without newline", "a\n", "a\nb", 1, { { 1, 0, 1, 1 } } },
+};
+
+// applies hunks to from, checking they are in order and don't overlap
+static bool apply(const QStringList &from, const QVector<LineDiffHunk> &hunks, const QStringList &to, QStringList &result) {
+  int done = 0;
+  for (int h = 0; h < hunks.size(); h++) {
+    const LineDiffHunk &hunk = hunks[h];
+    if (hunk.old_start < done || hunk.old_count < 0 || hunk.new_count < 0 ||
+        hunk.old_count + hunk.new_count == 0 ||
+        hunk.old_start + hunk.old_count > from.size() || hunk.new_start + hunk.new_count > to.size()) {
+      return false;
+    }
+    while (done < hunk.old_start) result << from[done++];
+    // unchanged lines line up in both lists
+    if (hunk.new_start != result.size()) {
+      return false;
+    }
+    for (int i = 0; i < hunk.new_count; i++) result << to[hunk.new_start + i];
+    done += hunk.old_count;
+  }
+  while (done < from.size()) result << from[done++];
+  return true;
+}
+
+static int changedLines(const QVector<LineDiffHunk> &hunks) {
+  int changed = 0;
+  for (int h = 0; h < hunks.size(); h++) changed += hunks[h].old_count + hunks[h].new_count;
+  return changed;
+}
+
+static int longestCommon(const QStringList &a, const QStringList &b) {
+  std::vector<std::vector<int> > lcs(a.size() + 1, std::vector<int>(b.size() + 1, 0));
+  for (int i = a.size() - 1; i >= 0; i--) {
+    for (int j = b.size() - 1; j >= 0; j--) {
+      lcs[i][j] = a[i] == b[j] ? lcs[i + 1][j + 1] + 1 : std::max(lcs[i + 1][j], lcs[i][j + 1]);
+    }
+  }
+  return lcs[0][0];
+}
+
+static QStringList numberedLines(int count, const char *prefix) {
+  QStringList lines;
+  for (int i = 0; i < count; i++) {
+    lines << QString((std::string(prefix) + std::to_string(i) + "\n").c_str());
+  }
+  return lines;
+}
+
+int main()
+{
+  int failed = 0;
+
+  for (const HunkCase &t : HUNK_CASES) {
+    QVector<LineDiffHunk> got = diffLines(splitLines(QString(t.from)), splitLines(QString(t.to)));
+    bool same = got.size() == t.hunk_count;
+    for (int h = 0; same && h < got.size(); h++) {
+      const LineDiffHunk &a = got[h];
+      const LineDiffHunk &b = t.hunks[h];
+      same = a.old_start == b.old_start && a.old_count == b.old_count &&
+        a.new_start == b.new_start && a.new_count == b.new_count;
+    }
+    if (!same) {
+      printf("FAIL %s: got %d hunk(s):", t.name, (int)got.size());
+      for (int h = 0; h < got.size(); h++) {
+        printf(" {%d,%d,%d,%d}", got[h].old_start, got[h].old_count, got[h].new_start, got[h].new_count);
+      }
+      printf("\n");
+      failed++;
+    }
+  }
+
+  // few distinct lines, so there are plenty of ways to line them up
+  std::mt19937 rng(1234);
+  static const char *const LINES[] = { "play 60\n", "sleep 1\n", "end\n", "live_loop :foo do\n", "\n", "sample :bd_haus\n" };
+  for (int trial = 0; trial < 3000 && failed < 10; trial++) {
+    QStringList from;
+    int size = rng() % 40;
+    for (int i = 0; i < size; i++) from << QString(LINES[rng() % 6]);
+    QStringList to = from;
+    int edits = rng() % 8;
+    for (int e = 0; e < edits; e++) {
+      int at = to.isEmpty() ? 0 : rng() % (to.size() + 1);
+      if (rng() % 2 && at < to.size()) {
+        to.removeAt(at);
+      } else {
+        to.insert(at, QString(LINES[rng() % 6]));
+      }
+    }
+
+    QVector<LineDiffHunk> hunks = diffLines(from, to);
+    QStringList result;
+    if (!apply(from, hunks, to, result) || result != to) {
+      printf("FAIL trial %d: hunks don't turn %d lines into %d\n", trial, (int)from.size(), (int)to.size());
+      failed++;
+    } else if (changedLines(hunks) != from.size() + to.size() - 2 * longestCommon(from, to)) {
+      printf("FAIL trial %d: %d lines changed, at least %d needed\n", trial, changedLines(hunks),
+             (int)(from.size() + to.size() - 2 * longestCommon(from, to)));
+      failed++;
+    }
+  }
+
+  // Between unchanged ends, keep every tenth line and replace the rest.
+  // diffLines gives up past 2048 inserted plus deleted lines.
+  QStringList common = numberedLines(50, "same ");
+  for (int size = 1000; size <= 1200; size += 200) {
+    QStringList from = common + numberedLines(size, "old ") + common;
+    QStringList to = common + numberedLines(size, "new ") + common;
+    for (int i = 0; i < size; i += 10) to[50 + i] = from[50 + i];
+    int edits = 2 * (size - size / 10);
+    QVector<LineDiffHunk> hunks = diffLines(from, to);
+    QStringList result;
+    if (!apply(from, hunks, to, result) || result != to) {
+      printf("FAIL %d edits: hunks don't turn one buffer into the other\n", edits);
+      failed++;
+    } else if (edits <= 2048 && hunks.size() != size / 10) {
+      printf("FAIL %d edits: %d hunks, expected %d\n", edits, (int)hunks.size(), size / 10);
+      failed++;
+    } else if (edits > 2048 && (hunks.size() != 1 || hunks[0].old_start != 51 || hunks[0].old_count != size - 1)) {
+      // the first kept line still matches at the head
+      printf("FAIL %d edits: %d hunks, expected one from line 51\n", edits, (int)hunks.size());
+      failed++;
+    }
+  }
+
+  printf("%d failure(s)\n", failed);
+  return failed ? 1 : 0;
+}
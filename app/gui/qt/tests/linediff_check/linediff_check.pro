@@ -0,0 +1,27 @@
+#--
+# This file is part of Sonic Pi: http://sonic-pi.net
+# Full project source: https://github.com/samaaron/sonic-pi
+# License: https://github.com/samaaron/sonic-pi/blob/master/LICENSE.md
+#
+# Copyright 2013, 2014, 2015, 2016 by Sam Aaron (http://sam.aaron.name).
+# All rights reserved.
+#
+# Permission is granted for use, copying, modification, distribution,
+# and distribution of modified versions of this work as long as this
+# notice is included.
+#++
+
+# diffLines check, built by ../tests.pro and run by make check.
+
+TEMPLATE = app
+TARGET = linediff_check
+CONFIG += console c++11 release testcase
+CONFIG -= app_bundle
+QT = core
+
+INCLUDEPATH += ../../utils
+
+SOURCES += linediff_check.cpp \
+           ../../utils/linediff.cpp
+
+HEADERS += ../../utils/linediff.h
@@ -0,0 +1,170 @@
+//--
+// This file is part of Sonic Pi: http://sonic-pi.net
+// Full project source: https://github.com/samaaron/sonic-pi
+// License: https://github.com/samaaron/sonic-pi/blob/master/LICENSE.md
+//
+// Copyright 2013, 2014, 2015, 2016 by Sam Aaron (http://sam.aaron.name).
+// All rights reserved.
+//
+// Permission is granted for use, copying, modification, and
+// distribution of modified versions of this work as long as this
+// notice is included.
+//++
+
+
+// Makes random edits to a buffer, reporting them to a RubyBlockIndex
+// the way SonicPiScintilla does, and after each one checks the indent
+// levels and block tree it gives against a fresh index built by
+// scanning the whole buffer, and the indents against RubyIndenter::scan.
+
+#include "rubyblockindex.h"
+
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+static const int EDITS = 20000;
+// the buffer grows to around this many lines and stays there
+static const int MAX_LINES = 200;
+
+// pieces of Ruby likely to open, close or split blocks and strings
+static const char *const FRAGMENTS[] = {
+  "live_loop :foo do", "with_fx :reverb do", "define :bar do", "in_thread do",
+  "3.times do |i|", "end", "if x", "else", "elsif y", "unless z", "case n",
+  "when 1", "begin", "rescue", "ensure", "while x do", "play 60 if x",
+  "play 60", "sleep 1", "n = if x", "play [60,", "62]", "x = {", "}",
+  "foo(", ")", "puts \"a", "b\"", "puts 'a", "b'", "%w(a", "b)", "=begin",
+  "=end", "# do", "play :end", "foo do: 1", "; if y", " ", "",
+};
+
+static const int FRAGMENT_COUNT = sizeof(FRAGMENTS) / sizeof(FRAGMENTS[0]);
+
+static std::string randomLine(std::mt19937 &rng) {
+  std::string line;
+  int pieces = rng() % 3 + 1;
+  for (int p = 0; p < pieces; p++) {
+    if (p) line += " ";
+    line += FRAGMENTS[rng() % FRAGMENT_COUNT];
+  }
+  return line;
+}
+
+static void rescan(RubyBlockIndex &index, const std::vector<std::string> &buffer, int upTo) {
+  int dirty;
+  while ((dirty = index.nextDirtyLine()) >= 0 && (upTo < 0 || dirty <= upTo)) {
+    index.rescanLine(dirty, QString(buffer[dirty].c_str()));
+  }
+}
+
+static bool sameBlock(const RubyBlock &a, const RubyBlock &b) {
+  return a.kind == b.kind && a.name == b.name && a.start_line == b.start_line &&
+    a.end_line == b.end_line && a.parent == b.parent && a.depth == b.depth &&
+    a.level == b.level;
+}
+
+int main()
+{
+  std::mt19937 rng(1234);
+  std::vector<std::string> buffer(1);
+  RubyBlockIndex index;
+  int failed = 0;
+
+  for (int edit = 0; edit < EDITS && failed < 10; edit++) {
+    int size = (int)buffer.size();
+    int line = rng() % size;
+    // inserting twice as often as joining lets the buffer grow
+    enum { Replace, Insert, Join, TwoLines };
+    static const int KINDS[] = { Replace, Insert, Insert, Join, TwoLines };
+    int kind = KINDS[rng() % 5];
+    if (kind == Insert && size >= MAX_LINES) kind = Join;
+
+    // Scintilla reports the line an edit starts on and how many lines
+    // it added or removed after it
+    if (kind == Replace) {
+      // replace the line's text
+      buffer[line] = randomLine(rng);
+      index.linesChanged(line, 0);
+    } else if (kind == Insert) {
+      // split the line and insert whole lines after it
+      int added = rng() % 4 + 1;
+      for (int i = 0; i < added; i++) {
+        buffer.insert(buffer.begin() + line + 1, randomLine(rng));
+      }
+      index.linesChanged(line, added);
+    } else if (kind == Join) {
+      // join the line with the ones after it
+      int removed = std::min<int>(rng() % 4 + 1, size - line - 1);
+      if (removed > 0) {
+        buffer[line] += " " + buffer[line + removed];
+        buffer.erase(buffer.begin() + line + 1, buffer.begin() + line + 1 + removed);
+      }
+      index.linesChanged(line, -removed);
+    } else {
+      // edit two distant lines before looking at the index
+      buffer[line] = randomLine(rng);
+      index.linesChanged(line, 0);
+      int other = rng() % size;
+      buffer[other] = randomLine(rng);
+      index.linesChanged(other, 0);
+    }
+
+    if (index.lineCount() != (int)buffer.size()) {
+      printf("FAIL edit %d: %d lines indexed, buffer has %d\n", edit, index.lineCount(), (int)buffer.size());
+      failed++;
+      continue;
+    }
+
+    // sometimes only ask for one line's indent, like newline and indent
+    if (rng() % 3) {
+      int at = rng() % buffer.size();
+      rescan(index, buffer, at);
+      RubyLineState state;
+      for (int l = 0; l <= at; l++) {
+        state = RubyIndenter::scan(QString(buffer[l].c_str()), state);
+      }
+      int got = index.indentLevel(at);
+      if (got != state.indent) {
+        printf("FAIL edit %d: line %d indent %d, full scan gives %d\n", edit, at, got, state.indent);
+        failed++;
+      }
+      continue;
+    }
+
+    rescan(index, buffer, -1);
+    RubyBlockIndex full;
+    full.linesChanged(0, (int)buffer.size() - 1);
+    rescan(full, buffer, -1);
+
+    const QVector<RubyBlock> &got = index.blocks();
+    const QVector<RubyBlock> &want = full.blocks();
+    if (got.size() != want.size()) {
+      printf("FAIL edit %d: %d blocks, full scan finds %d\n", edit, (int)got.size(), (int)want.size());
+      failed++;
+      continue;
+    }
+    for (int b = 0; b < got.size(); b++) {
+      if (!sameBlock(got[b], want[b])) {
+        printf("FAIL edit %d: block %d differs from full scan\n", edit, b);
+        failed++;
+        break;
+      }
+    }
+    for (int l = 0; l < (int)buffer.size(); l++) {
+      // the innermost block holding l is the last to start by then
+      // that hasn't ended
+      int wantAt = -1;
+      for (int b = 0; b < want.size() && want[b].start_line <= l; b++) {
+        if (want[b].end_line < 0 || want[b].end_line >= l) wantAt = b;
+      }
+      if (index.indentLevel(l) != full.indentLevel(l) || index.blockAt(l) != wantAt) {
+        printf("FAIL edit %d: line %d differs from full scan\n", edit, l);
+        failed++;
+        break;
+      }
+    }
+  }
+
+  printf("%d failure(s), %d lines at the end\n", failed, (int)buffer.size());
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,30 @@
+#--
+# This file is part of Sonic Pi: http://sonic-pi.net
+# Full project source: https://github.com/samaaron/sonic-pi
+# License: https://github.com/samaaron/sonic-pi/blob/master/LICENSE.md
+#
+# Copyright 2013, 2014, 2015, 2016 by Sam Aaron (http://sam.aaron.name).
+# All rights reserved.
+#
+# Permission is granted for use, copying, modification, distribution,
+# and distribution of modified versions of this work as long as this
+# notice is included.
+#++
+
+# RubyBlockIndex randomized incremental check, built by ../tests.pro and
+# run by make check.
+
+TEMPLATE = app
+TARGET = rubyblockindex_check
+CONFIG += console c++11 release testcase
+CONFIG -= app_bundle
+QT = core
+
+INCLUDEPATH += ../../utils
+
+SOURCES += rubyblockindex_check.cpp \
+           ../../utils/rubyblockindex.cpp \
+           ../../utils/rubyindenter.cpp
+
+HEADERS += ../../utils/rubyblockindex.h \
+           ../../utils/rubyindenter.h
@@ -0,0 +1,169 @@
+//--
+// This file is part of Sonic Pi: http://sonic-pi.net
+// Full project source: https://github.com/samaaron/sonic-pi
+// License: https://github.com/samaaron/sonic-pi/blob/master/LICENSE.md
+//
+// Copyright 2013, 2014, 2015, 2016 by Sam Aaron (http://sam.aaron.name).
+// All rights reserved.
+//
+// Permission is granted for use, copying, modification, and
+// distribution of modified versions of this work as long as this
+// notice is included.
+//++
+
+
+// Feeds each snippet below through RubyIndenter::scan a line at a time
+// and checks the indent level it gives every line (-1 meaning the line
+// is left alone), then checks the block tokens found on a few lines.
+
+#include "rubyindenter.h"
+
+#include <cstdio>
+
+static const int MAX_LINES = 10;
+
+struct IndentCase
+{
+  const char *name;
+  const char *lines[MAX_LINES + 1];  // ends with 0
+  int indent[MAX_LINES];
+};
+
+static const IndentCase INDENT_CASES[] = {
+  { "do/end",
+    { "live_loop :foo do", "play 60", "sleep 1", "end", "play 62", 0 },
+    { 0, 1, 1, 0, 0 } },
+  { "nested do/end",
+    { "in_thread do", "3.times do |i|", "play i", "end", "end", 0 },
+    { 0, 1, 2, 1, 0 } },
+  { "do/end on one line",
+    { "loop do play 60 end", "sleep 1", 0 },
+    { 0, 0 } },
+  { "def",
+    { "define :foo do", "play 60", "end", "def bar(x)", "x + 1", "end", 0 },
+    { 0, 1, 0, 0, 1, 0 } },
+  { "if elsif else",
+    { "if x", "play 1", "elsif y", "play 2", "else", "play 3", "end", 0 },
+    { 0, 1, 0, 1, 0, 1, 0 } },
+  { "case when",
+    { "case n", "when 1", "play 60", "when 2", "play 62", "end", 0 },
+    { 0, 0, 1, 0, 1, 0 } },
+  { "begin rescue ensure",
+    { "begin", "play 1", "rescue", "play 2", "ensure", "play 3", "end", 0 },
+    { 0, 1, 0, 1, 0, 1, 0 } },
+  { "while with do",
+    { "while x do", "play 1", "end", "until y", "play 2", "end", 0 },
+    { 0, 1, 0, 0, 1, 0 } },
+  { "modifier if",
+    { "play 60 if one_in(2)", "play 62 unless x", "sleep 1 while y", "play 64", 0 },
+    { 0, 0, 0, 0 } },
+  { "if as a value",
+    { "n = if x", "60", "else", "62", "end", "play n", 0 },
+    { 0, 1, 0, 1, 0, 0 } },
+  { "if after a statement separator",
+    { "play 1; if x", "play 2", "end", 0 },
+    { 0, 1, 0 } },
+  { "keywords as symbols, methods and keys",
+    { "play :end", "sample :do", "x.if", "foo if: 1, end: 2", "play 60", 0 },
+    { 0, 0, 0, 0, 0 } },
+  { "brackets",
+    { "play_pattern [60,", "62,", "64]", "play 60", 0 },
+    { 0, 1, 1, 0 } },
+  { "closing brackets start a line",
+    { "x = {", "a: 1,", "b: [", "2", "]", "}", "play 60", 0 },
+    { 0, 1, 1, 2, 1, 0, 0 } },
+  { "brackets and do",
+    { "foo(bar do", "play 1", "end)", "play 2", 0 },
+    { 0, 1, 0, 0 } },
+  { "comments",
+    { "play 60 # do", "# if x", "play 62", 0 },
+    { 0, 0, 0 } },
+  { "double quoted string spanning lines",
+    { "puts \"one", "  do if [", "end\"", "play 60", 0 },
+    { 0, -1, -1, 0 } },
+  { "single quoted string spanning lines",
+    { "in_thread do", "puts 'a", "b'", "play 60", "end", 0 },
+    { 0, 1, -1, 1, 0 } },
+  { "string closed then block opened",
+    { "puts \"a", "b\"; loop do", "play 1", "end", 0 },
+    { 0, -1, 1, 0 } },
+  { "escaped quote",
+    { "puts \"a \\\" do\"", "play 60", 0 },
+    { 0, 0 } },
+  { "percent literal spanning lines",
+    { "x = %w(a", "do b)", "play 60", 0 },
+    { 0, -1, 0 } },
+  { "comment block",
+    { "=begin", "do", "=end", "play 60", 0 },
+    { -1, -1, -1, 0 } },
+};
+
+struct TokenCase
+{
+  const char *line;
+  RubyBlockToken::Type type;
+  const char *kind;
+  const char *name;
+};
+
+// the first token found on each line
+static const TokenCase TOKEN_CASES[] = {
+  { "live_loop :foo do", RubyBlockToken::Open, "live_loop", ":foo" },
+  { "with_fx :reverb, mix: 0.5 do", RubyBlockToken::Open, "with_fx", ":reverb" },
+  { "in_thread name: :bar do", RubyBlockToken::Open, "in_thread", ":bar" },
+  { "define \"baz\" do", RubyBlockToken::Open, "define", "\"baz\"" },
+  { "def qux(a)", RubyBlockToken::Open, "def", "qux" },
+  { "x.each do |y|", RubyBlockToken::Open, "each", "" },
+  { "else", RubyBlockToken::Middle, "else", "" },
+  { "end", RubyBlockToken::Close, "end", "" },
+  { "play [60, 62]", RubyBlockToken::Open, "[", "" },
+};
+
+static const char *typeName(RubyBlockToken::Type type) {
+  switch (type) {
+  case RubyBlockToken::Open: return "open";
+  case RubyBlockToken::Middle: return "middle";
+  case RubyBlockToken::Close: return "close";
+  }
+  return "?";
+}
+
+int main()
+{
+  int failed = 0;
+
+  for (const IndentCase &t : INDENT_CASES) {
+    RubyLineState state;
+    for (int l = 0; t.lines[l]; l++) {
+      state = RubyIndenter::scan(QString(t.lines[l]), state);
+      if (state.indent != t.indent[l]) {
+        printf("FAIL %s: line %d '%s' indent %d, expected %d\n",
+               t.name, l, t.lines[l], state.indent, t.indent[l]);
+        failed++;
+      }
+    }
+  }
+
+  for (const TokenCase &t : TOKEN_CASES) {
+    QVector<RubyBlockToken> tokens;
+    // middle keywords and closers need an open block to sit in
+    RubyLineState before;
+    before.open << 0;
+    RubyIndenter::scan(QString(t.line), before, &tokens);
+    if (tokens.isEmpty()) {
+      printf("FAIL '%s': no tokens\n", t.line);
+      failed++;
+      continue;
+    }
+    const RubyBlockToken &got = tokens[0];
+    if (got.type != t.type || got.kind != QString(t.kind) || got.name != QString(t.name)) {
+      printf("FAIL '%s': %s %s %s, expected %s %s %s\n", t.line,
+             typeName(got.type), got.kind.toStdString().c_str(), got.name.toStdString().c_str(),
+             typeName(t.type), t.kind, t.name);
+      failed++;
+    }
+  }
+
+  printf("%d failure(s)\n", failed);
+  return failed ? 1 : 0;
+}
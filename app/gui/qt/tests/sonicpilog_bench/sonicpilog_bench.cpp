@@ -0,0 +1,199 @@
+//--
+// This file is part of Sonic Pi: http://sonic-pi.net
+// Full project source: https://github.com/samaaron/sonic-pi
+// License: https://github.com/samaaron/sonic-pi/blob/master/LICENSE.md
+//
+// Copyright 2013, 2014, 2015, 2016 by Sam Aaron (http://sam.aaron.name).
+// All rights reserved.
+//
+// Permission is granted for use, copying, modification, and
+// distribution of modified versions of this work as long as this
+// notice is included.
+//++
+
+
+// Measures how many multi messages per second SonicPiLog can render,
+// using the mix of message types and line counts a busy run produces.
+// The same messages are also rendered by a copy of the insertion code
+// from before the per theme formats, on a plain QPlainTextEdit set up
+// the same way, so both numbers come from one build.
+
+#include <QApplication>
+#include <QElapsedTimer>
+#include <QPlainTextEdit>
+#include <QRegExp>
+#include <QScrollBar>
+#include <QStringList>
+#include <QTextCursor>
+#include <algorithm>
+#include <iostream>
+#include "sonicpilog.h"
+#include "model/sonicpitheme.h"
+
+static const int ROUNDS = 20;
+static const int MESSAGES_PER_ROUND = 500;
+
+static void baselineAppendBlock(QPlainTextEdit &log, QTextCursor &cursor, const QString &text, const QTextCharFormat &tf)
+{
+  if(!log.document()->isEmpty()) {
+    cursor.insertBlock();
+  }
+  cursor.insertText(text, tf);
+}
+
+// SonicPiLog::insertMultiMessage as it was, looking up and parsing two
+// theme colours per line and splitting messages with a regex
+static void baselineMultiMessage(QPlainTextEdit &log, const SonicPiLog::MultiMessage &mm)
+{
+  QTextCursor cursor(log.document());
+  cursor.movePosition(QTextCursor::End);
+  cursor.beginEditBlock();
+
+  int msg_count = mm.messages.size();
+  SonicPiTheme *theme = mm.theme;
+  QTextCharFormat tf;
+  QString ss;
+
+  tf.setForeground(theme->color("LogForeground"));
+  tf.setBackground(theme->color("LogBackground"));
+
+  ss.append("{run: ").append(QString::number(mm.job_id));
+  ss.append(", time: ").append(QString::fromStdString(mm.runtime));
+  if(! (mm.thread_name == "\"\"")) {
+    ss.append(", thread: ").append(QString::fromStdString(mm.thread_name));
+  }
+  ss.append("}");
+  baselineAppendBlock(log, cursor, ss, tf);
+
+  for(int i = 0 ; i < msg_count ; i++) {
+    ss = "";
+    int msg_type = mm.messages[i].msg_type;
+    const std::string &s = mm.messages[i].s;
+    QStringList lines = QString::fromUtf8(s.c_str()).split(QRegExp("\\n"));
+
+    if (s.empty()) {
+      ss.append(QString::fromUtf8(" │"));
+    } else if(i == (msg_count - 1)) {
+      ss.append(QString::fromUtf8(" └─ "));
+    } else {
+      ss.append(QString::fromUtf8(" ├─ "));
+    }
+    baselineAppendBlock(log, cursor, ss, tf);
+
+    for (int j = 0; j < lines.size(); ++j) {
+      switch(msg_type) {
+      case 1:
+        tf.setForeground(theme->color("LogForeground_1"));
+        tf.setBackground(theme->color("LogBackground_1"));
+        break;
+      case 2:
+        tf.setForeground(theme->color("LogForeground_2"));
+        tf.setBackground(theme->color("LogBackground_2"));
+        break;
+      case 3:
+        tf.setForeground(theme->color("LogForeground_3"));
+        tf.setBackground(theme->color("LogBackground_3"));
+        break;
+      case 4:
+        tf.setForeground(theme->color("LogForeground_4"));
+        tf.setBackground(theme->color("LogBackground_4"));
+        break;
+      case 5:
+        tf.setForeground(theme->color("LogForeground_5"));
+        tf.setBackground(theme->color("LogBackground_5"));
+        break;
+      case 6:
+        tf.setForeground(theme->color("LogForeground_6"));
+        tf.setBackground(theme->color("LogBackground_6"));
+        break;
+      default:
+        tf.setForeground(theme->color("LogForeground"));
+        tf.setBackground(theme->color("LogBackground"));
+      }
+      cursor.insertText(lines.at(j), tf);
+      if ((j + 1) < lines.size()) {
+        tf.setForeground(theme->color("LogForeground"));
+        cursor.insertText((i == (msg_count - 1)) ? "\n  " : "\n │", tf);
+      }
+    }
+
+    tf.setForeground(theme->color("LogForeground"));
+    tf.setBackground(theme->color("LogBackground"));
+  }
+  baselineAppendBlock(log, cursor, QString::fromStdString(" "), tf);
+  cursor.endEditBlock();
+
+  QScrollBar *sb = log.verticalScrollBar();
+  sb->setValue(sb->maximum());
+}
+
+struct Result
+{
+  double mean;
+  double best;
+};
+
+template <typename Render, typename Clear>
+static Result run(QApplication &app, SonicPiLog::MultiMessage mm, Render render, Clear clear)
+{
+  // warm up the layout and any lazily built formats
+  render(mm);
+  clear();
+
+  Result result = { 0, 0 };
+  double total = 0;
+  for (int round = 0; round < ROUNDS; round++) {
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < MESSAGES_PER_ROUND; i++) {
+      mm.job_id = i;
+      render(mm);
+    }
+    app.processEvents();
+    double secs = timer.nsecsElapsed() / 1e9;
+    result.best = std::max(result.best, MESSAGES_PER_ROUND / secs);
+    total += secs;
+    clear();
+  }
+  result.mean = ROUNDS * MESSAGES_PER_ROUND / total;
+  return result;
+}
+
+int main(int argc, char *argv[])
+{
+  QApplication app(argc, argv);
+  SonicPiTheme theme(0, "", "");
+
+  SonicPiLog log;
+  log.resize(600, 400);
+
+  // the old pane relied on the document's block cap to stay bounded
+  QPlainTextEdit baseline;
+  baseline.resize(600, 400);
+  baseline.document()->setUndoRedoEnabled(false);
+  baseline.document()->setMaximumBlockCount(1000);
+
+  SonicPiLog::MultiMessage mm;
+  mm.theme = &theme;
+  mm.job_id = 1;
+  mm.thread_name = "\"live_loop_drums\"";
+  mm.runtime = "12.5";
+  for (int i = 0; i < 4; i++) {
+    SonicPiLog::Message m;
+    m.msg_type = i % 7;
+    m.s = (i == 3) ? "synth :beep, {note: 60.0, release: 0.2}\n  with a second line" : "sample :bd_haus, {amp: 1.5}";
+    mm.messages.push_back(m);
+  }
+
+  Result before = run(app, mm,
+                      [&](const SonicPiLog::MultiMessage &m) { baselineMultiMessage(baseline, m); },
+                      [&]() { baseline.clear(); });
+  Result after = run(app, mm,
+                     [&](const SonicPiLog::MultiMessage &m) { log.handleMultiMessage(m); },
+                     [&]() { log.clear(); });
+
+  std::cout << "multi messages/sec (" << mm.messages.size() << " messages each), mean / best:" << std::endl;
+  std::cout << "  baseline:   " << (int)before.mean << " / " << (int)before.best << std::endl;
+  std::cout << "  SonicPiLog: " << (int)after.mean << " / " << (int)after.best << std::endl;
+  return 0;
+}
@@ -0,0 +1,33 @@
+#--
+# This file is part of Sonic Pi: http://sonic-pi.net
+# Full project source: https://github.com/samaaron/sonic-pi
+# License: https://github.com/samaaron/sonic-pi/blob/master/LICENSE.md
+#
+# Copyright 2013, 2014, 2015, 2016 by Sam Aaron (http://sam.aaron.name).
+# All rights reserved.
+#
+# Permission is granted for use, copying, modification, distribution,
+# and distribution of modified versions of this work as long as this
+# notice is included.
+#++
+
+# SonicPiLog multi message benchmark, built by ../tests.pro. Run it by hand:
+#   QT_QPA_PLATFORM=offscreen ./sonicpilog_bench
+#
+# Prints the current SonicPiLog rate next to a baseline copy of the
+# insertion code it replaced, so no second build is needed.
+
+TEMPLATE = app
+TARGET = sonicpilog_bench
+CONFIG += console c++11 release
+CONFIG -= app_bundle
+QT += core gui widgets concurrent
+
+INCLUDEPATH += ../.. ../../widgets
+
+SOURCES += sonicpilog_bench.cpp \
+           ../../widgets/sonicpilog.cpp \
+           ../../model/sonicpitheme.cpp
+
+HEADERS += ../../widgets/sonicpilog.h \
+           ../../model/sonicpitheme.h
@@ -0,0 +1,28 @@
+#--
+# This file is part of Sonic Pi: http://sonic-pi.net
+# Full project source: https://github.com/samaaron/sonic-pi
+# License: https://github.com/samaaron/sonic-pi/blob/master/LICENSE.md
+#
+# Copyright 2013, 2014, 2015, 2016 by Sam Aaron (http://sam.aaron.name).
+# All rights reserved.
+#
+# Permission is granted for use, copying, modification, distribution,
+# and distribution of modified versions of this work as long as this
+# notice is included.
+#++
+
+# Checks and benchmarks for GUI code, built apart from the GUI itself:
+#   qmake tests.pro && make && make check
+#
+# make check runs the checks and stops at the first failure. The
+# benchmarks only print numbers, so they are built but left to be run
+# by hand from their directories.
+
+TEMPLATE = subdirs
+
+SUBDIRS += udppacketring_bench \
+           dspkernels_bench \
+           sonicpilog_bench \
+           rubyindenter_check \
+           rubyblockindex_check \
+           linediff_check
@@ -0,0 +1,174 @@
+//--
+// This file is part of Sonic Pi: http://sonic-pi.net
+// Full project source: https://github.com/samaaron/sonic-pi
+// License: https://github.com/samaaron/sonic-pi/blob/master/LICENSE.md
+//
+// Copyright 2013, 2014, 2015, 2016 by Sam Aaron (http://sam.aaron.name).
+// All rights reserved.
+//
+// Permission is granted for use, copying, modification, and
+// distribution of modified versions of this work as long as this
+// notice is included.
+//++
+
+// Standalone benchmark for UdpPacketRing: blasts OSC messages at a
+// loopback socket from a second thread and reports how fast they are
+// received and parsed, and how many heap allocations each packet costs,
+// first through UdpSocket::receiveNextPacket and PacketReader the way
+// the GUI's UDP server used to, then through the ring.
+//
+//   qmake udppacketring_bench.pro && make && ./udppacketring_bench [packets] [size]
+
+#include "udppacketring.h"
+#include "oscpkt.hh"
+#include "udp.hh"
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__GNUC__)
+# define BENCH_NOINLINE __attribute__((noinline))
+#else
+# define BENCH_NOINLINE
+#endif
+
+static std::atomic<unsigned long> allocations(0);
+
+// Kept out of line: once operator delete is inlined next to an inlined
+// operator new, GCC mistakes the free for a mismatched deallocation.
+static BENCH_NOINLINE void release(void *p)
+{
+  free(p);
+}
+
+void *operator new(size_t size)
+{
+  allocations++;
+  void *p = malloc(size ? size : 1);
+  if (!p) throw std::bad_alloc();
+  return p;
+}
+
+void operator delete(void *p) noexcept
+{
+  release(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+  release(p);
+}
+
+struct Totals
+{
+  Totals() : packets(0), messages(0), bytes(0) {}
+  unsigned long packets;
+  unsigned long messages;
+  unsigned long bytes;
+  std::string text;
+};
+
+// what the receive loops do with each message: read its arguments
+static void parse(oscpkt::PacketReader &pr, const void *data, size_t size, Totals &totals)
+{
+  pr.init(data, size);
+  oscpkt::Message *msg;
+  while (pr.isOk() && (msg = pr.popMessage()) != 0) {
+    int32_t n;
+    msg->arg().popInt32(n).popStr(totals.text);
+    totals.messages++;
+  }
+  totals.packets++;
+  totals.bytes += size;
+}
+
+// the old OscHandler::oscMessage took the packet by value
+static void handleCopy(std::vector<char> buffer, oscpkt::PacketReader &pr, Totals &totals)
+{
+  parse(pr, &buffer[0], buffer.size(), totals);
+}
+
+enum Path { BASELINE, RING };
+
+static void run(Path path, unsigned long total, size_t size)
+{
+  oscpkt::UdpSocket receiver;
+  receiver.bindTo(0);
+  // a large receive buffer so the sender rarely outruns us
+  int buffer = 4 * 1024 * 1024;
+  setsockopt(receiver.socketHandle(), SOL_SOCKET, SO_RCVBUF, (const char *)&buffer, sizeof(buffer));
+
+  oscpkt::UdpSocket sender;
+  sender.connectTo("127.0.0.1", receiver.boundPort());
+  oscpkt::PacketWriter pw;
+  oscpkt::Message m("/log/info");
+  m.pushInt32(1).pushStr(std::string(size, 'x'));
+  pw.addMessage(m);
+
+  std::atomic<bool> sending(true);
+  std::thread blaster([&]() {
+    for (unsigned long i = 0; i < total; i++) {
+      sender.sendPacket(pw.packetData(), pw.packetSize());
+    }
+    sending = false;
+  });
+
+  UdpPacketRing ring;
+  oscpkt::PacketReader pr;
+  Totals totals;
+  unsigned long before = allocations;
+  auto start = std::chrono::steady_clock::now();
+  // stop once the sender is done and the socket has gone quiet, since
+  // loopback may still drop packets under load
+  if (path == BASELINE) {
+    while (receiver.isOk()) {
+      if (receiver.receiveNextPacket(50)) {
+        handleCopy(receiver.buffer, pr, totals);
+        std::vector<char>().swap(receiver.buffer);
+      } else if (!sending) {
+        break;
+      }
+    }
+  } else {
+    while (true) {
+      int n = ring.receive(receiver.socketHandle(), 50);
+      if (n < 0) break;
+      if (n == 0 && !sending) break;
+      for (int i = 0; i < n; i++) {
+        parse(pr, ring.packetData(i), ring.packetSize(i), totals);
+      }
+    }
+  }
+  auto end = std::chrono::steady_clock::now();
+  unsigned long used = allocations - before;
+  blaster.join();
+
+  double secs = std::chrono::duration<double>(end - start).count();
+  std::cout << (path == BASELINE ? "receiveNextPacket" : "UdpPacketRing") << std::endl;
+  std::cout << "  received " << totals.packets << " of " << total << " x " << pw.packetSize() << " bytes"
+            << " (" << totals.messages << " messages parsed)" << std::endl;
+  std::cout << "  packets/sec: " << (unsigned long)(totals.packets / secs) << std::endl;
+  std::cout << "  MB/sec: " << totals.bytes / secs / (1024 * 1024) << std::endl;
+  if (path == RING) {
+    std::cout << "  packets/syscall: " << (double)ring.packetCount() / (ring.syscallCount() ? ring.syscallCount() : 1)
+              << " (max batch " << ring.highWaterMark() << ")" << std::endl;
+  }
+  std::cout << "  allocations/packet: " << (totals.packets ? (double)used / totals.packets : 0.0) << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+  unsigned long total = argc > 1 ? strtoul(argv[1], 0, 10) : 200000;
+  size_t size = argc > 2 ? strtoul(argv[2], 0, 10) : 64;
+
+  run(BASELINE, total, size);
+  run(RING, total, size);
+  return 0;
+}
@@ -0,0 +1,32 @@
+#--
+# This file is part of Sonic Pi: http://sonic-pi.net
+# Full project source: https://github.com/samaaron/sonic-pi
+# License: https://github.com/samaaron/sonic-pi/blob/master/LICENSE.md
+#
+# Copyright 2013, 2014, 2015, 2016 by Sam Aaron (http://sam.aaron.name).
+# All rights reserved.
+#
+# Permission is granted for use, copying, modification, distribution,
+# and distribution of modified versions of this work as long as this
+# notice is included.
+#++
+
+# UdpPacketRing benchmark, built by ../tests.pro. Run it by hand:
+#   ./udppacketring_bench
+
+TEMPLATE = app
+TARGET = udppacketring_bench
+CONFIG += console c++11 release
+CONFIG -= qt app_bundle
+
+INCLUDEPATH += ../../osc
+
+unix:LIBS += -lpthread
+win32:LIBS += -lws2_32
+
+SOURCES += udppacketring_bench.cpp \
+           ../../osc/udppacketring.cpp
+
+HEADERS += ../../osc/udppacketring.h \
+           ../../osc/oscpkt.hh \
+           ../../osc/udp.hh
@@ -0,0 +1,240 @@
+//--
+// This file is part of Sonic Pi: http://sonic-pi.net
+// Full project source: https://github.com/samaaron/sonic-pi
+// License: https://github.com/samaaron/sonic-pi/blob/master/LICENSE.md
+//
+// Copyright 2013, 2014, 2015, 2016 by Sam Aaron (http://sam.aaron.name).
+// All rights reserved.
+//
+// Permission is granted for use, copying, modification, and
+// distribution of modified versions of this work as long as this
+// notice is included.
+//++
+
+#include <algorithm>
+#include <utility>
+
+#include "fuzzymatcher.h"
+
+// the most completions offered for a non empty word
+static const int MAX_RESULTS = 100;
+// how many of the latest completions get a recency bonus
+static const unsigned int RECENT_WINDOW = 64;
+
+static const int MATCH_SCORE = 16;
+static const int START_BONUS = 24;
+static const int BOUNDARY_BONUS = 12;
+static const int CONSECUTIVE_BONUS = 8;
+static const int CASE_BONUS = 1;
+static const int GAP_PENALTY = 2;
+static const int MAX_GAP = 8;
+
+static inline QChar fold(QChar c) {
+  return c.toLower();
+}
+
+static inline bool isSigil(QChar c) {
+  return c == ':' || c == '"' || c == '\'';
+}
+
+static inline bool isBoundary(QChar c) {
+  return isSigil(c) || c == '_' || c == '/' || c == '.' || c == ' ';
+}
+
+static int maskBit(QChar c) {
+  ushort u = fold(c).unicode();
+  if (u >= 'a' && u <= 'z') return u - 'a';
+  if (u >= '0' && u <= '9') return 26 + (u - '0');
+  switch (u) {
+  case '_': return 36;
+  case ':': return 37;
+  case '?': return 38;
+  case '!': return 39;
+  case '/': return 40;
+  case '"': return 41;
+  case '\'': return 42;
+  case '-': return 43;
+  case '.': return 44;
+  case '+': return 45;
+  }
+  // everything else shares the remaining bits, which can only let
+  // through extra candidates for score() to reject
+  return 46 + u % 18;
+}
+
+FuzzyMatcher::FuzzyMatcher()
+  : uses(0), cacheKey(-1), cacheRevision(0), cacheUses(0), cacheComplete(false)
+{
+}
+
+quint64 FuzzyMatcher::charMask(const QString &word) {
+  quint64 mask = 0;
+  for (int i = 0; i < word.length(); i++) {
+    mask |= quint64(1) << maskBit(word[i]);
+  }
+  return mask;
+}
+
+int FuzzyMatcher::score(const QString &pattern, const QString &candidate) {
+  int m = pattern.length();
+  int n = candidate.length();
+  if (m == 0) return 0;
+  if (m > n) return -1;
+
+  // the earliest point the whole pattern has been seen
+  int end = -1;
+  for (int i = 0, p = 0; i < n; i++) {
+    if (fold(candidate[i]) == fold(pattern[p]) && ++p == m) {
+      end = i;
+      break;
+    }
+  }
+  if (end < 0) return -1;
+
+  // then walk back from there for the tightest window ending at it
+  int start = 0;
+  for (int i = end, p = m - 1; i >= 0; i--) {
+    if (fold(candidate[i]) == fold(pattern[p]) && --p < 0) {
+      start = i;
+      break;
+    }
+  }
+
+  int total = 0;
+  int prev = -1;
+  for (int i = start, p = 0; i <= end && p < m; i++) {
+    if (fold(candidate[i]) != fold(pattern[p])) continue;
+
+    int s = MATCH_SCORE;
+    if (i == 0 || (i == 1 && isSigil(candidate[0]))) {
+      s += START_BONUS;
+    } else if (isBoundary(candidate[i - 1])) {
+      s += BOUNDARY_BONUS;
+    }
+    if (prev >= 0) {
+      if (prev == i - 1) {
+        s += CONSECUTIVE_BONUS;
+      } else {
+        s -= GAP_PENALTY * std::min(i - prev - 1, MAX_GAP);
+      }
+    }
+    if (candidate[i] == pattern[p]) s += CASE_BONUS;
+
+    total += s;
+    prev = i;
+    p++;
+  }
+
+  // between otherwise equal matches prefer the shorter word
+  total -= (n - m) / 4;
+  return std::max(total, 0);
+}
+
+int FuzzyMatcher::recencyBonus(const QString &word) const {
+  QHash<QString, unsigned int>::const_iterator it = recent.constFind(word);
+  if (it == recent.constEnd()) return 0;
+  unsigned int age = uses - it.value();
+  return age < RECENT_WINDOW ? (int)(RECENT_WINDOW - age) : 0;
+}
+
+void FuzzyMatcher::noteUsed(const QString &word) {
+  recent.insert(word, ++uses);
+
+  // forget anything that no longer earns a bonus
+  if ((unsigned int)recent.size() > 4 * RECENT_WINDOW) {
+    QHash<QString, unsigned int>::iterator it = recent.begin();
+    while (it != recent.end()) {
+      if (uses - it.value() >= RECENT_WINDOW) {
+        it = recent.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+}
+
+QStringList FuzzyMatcher::rank(int key, unsigned int revision, const QString &pattern,
+                               const QStringList &words, const QVector<quint64> &masks,
+                               int first, int last) {
+  if (pattern.isEmpty()) return words;
+
+  bool sameWords = key == cacheKey && revision == cacheRevision;
+  if (sameWords && uses == cacheUses && pattern == cachePattern) {
+    return cacheResult;
+  }
+
+  quint64 need = charMask(pattern);
+  QVector<int> hits;
+  // words are sorted, so breaking ties on the index keeps them
+  // alphabetical
+  QVector<std::pair<int, int> > prefixScored;
+  QVector<std::pair<int, int> > restScored;
+
+  // every word starting with pattern is also a fuzzy match, and they
+  // are offered first
+  for (int i = first; i < last; i++) {
+    int s = score(pattern, words[i]);
+    if (s < 0) continue;
+    hits << i;
+    prefixScored << std::make_pair(-(s + recencyBonus(words[i])), i);
+  }
+
+  // Fuzzy matches from the rest fill what is left. Anything matching
+  // the longer pattern also matched the shorter one, so only the
+  // previous hits need rescoring, as long as they were all found.
+  bool complete = prefixScored.size() < MAX_RESULTS;
+  if (complete) {
+    bool narrowing = sameWords && cacheComplete &&
+      !cachePattern.isEmpty() && pattern.startsWith(cachePattern, Qt::CaseInsensitive);
+    int count = narrowing ? cacheHits.size() : words.size();
+    for (int k = 0; k < count; k++) {
+      int i = narrowing ? cacheHits[k] : k;
+      if ((i >= first && i < last) || (masks[i] & need) != need) continue;
+      int s = score(pattern, words[i]);
+      if (s < 0) continue;
+      hits << i;
+      restScored << std::make_pair(-(s + recencyBonus(words[i])), i);
+    }
+  }
+
+  int keepPrefix = std::min(prefixScored.size(), MAX_RESULTS);
+  std::partial_sort(prefixScored.begin(), prefixScored.begin() + keepPrefix, prefixScored.end());
+  int keepRest = std::min(restScored.size(), MAX_RESULTS - keepPrefix);
+  std::partial_sort(restScored.begin(), restScored.begin() + keepRest, restScored.end());
+
+  QStringList result;
+  for (int k = 0; k < keepPrefix; k++) {
+    result << words[prefixScored[k].second];
+  }
+  for (int k = 0; k < keepRest; k++) {
+    result << words[restScored[k].second];
+  }
+
+  cacheKey = key;
+  cacheRevision = revision;
+  cacheUses = uses;
+  cachePattern = pattern;
+  cacheComplete = complete;
+  cacheHits = hits;
+  cacheResult = result;
+  return result;
+}
+
+QStringList FuzzyMatcher::rank(const QString &pattern, const QStringList &words) {
+  if (pattern.isEmpty()) return words;
+
+  QVector<std::pair<int, int> > scored;
+  for (int i = 0; i < words.size(); i++) {
+    int s = score(pattern, words[i]);
+    if (s >= 0) {
+      scored << std::make_pair(-(s + recencyBonus(words[i])), i);
+    }
+  }
+  std::sort(scored.begin(), scored.end());
+
+  QStringList result;
+  for (int k = 0; k < scored.size(); k++) {
+    result << words[scored[k].second];
+  }
+  return result;
+}
@@ -0,0 +1,68 @@
+//--
+// This file is part of Sonic Pi: http://sonic-pi.net
+// Full project source: https://github.com/samaaron/sonic-pi
+// License: https://github.com/samaaron/sonic-pi/blob/master/LICENSE.md
+//
+// Copyright 2013, 2014, 2015, 2016 by Sam Aaron (http://sam.aaron.name).
+// All rights reserved.
+//
+// Permission is granted for use, copying, modification, and
+// distribution of modified versions of this work as long as this
+// notice is included.
+//++
+
+#ifndef FUZZYMATCHER_H
+#define FUZZYMATCHER_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QHash>
+
+// Ranks completion candidates by how well the typed word matches them
+// as a case insensitive subsequence, so bdh finds :bd_haus. Matches at
+// the start of a word, after _ : or / and in runs score higher, as do
+// words that were completed recently.
+class FuzzyMatcher
+{
+ public:
+  FuzzyMatcher();
+
+  // One bit per character class present in word. A candidate can only
+  // match if it has every bit of the pattern's mask.
+  static quint64 charMask(const QString &word);
+
+  // Score of pattern against candidate, or -1 if it isn't a subsequence.
+  static int score(const QString &pattern, const QString &candidate);
+
+  // Ranks words (with their charMasks) against pattern. The words
+  // starting with pattern, words[first, last), come first, best first,
+  // followed by the best fuzzy matches from the other words. When the
+  // same key and revision are asked again with a pattern that extends
+  // the previous one only the previous matches are rescored.
+  QStringList rank(int key, unsigned int revision, const QString &pattern,
+                   const QStringList &words, const QVector<quint64> &masks,
+                   int first, int last);
+
+  // Ranks a short list without touching the cache.
+  QStringList rank(const QString &pattern, const QStringList &words);
+
+  void noteUsed(const QString &word);
+
+ private:
+  int recencyBonus(const QString &word) const;
+
+  QHash<QString, unsigned int> recent;
+  unsigned int uses;
+
+  int cacheKey;
+  unsigned int cacheRevision;
+  unsigned int cacheUses;
+  QString cachePattern;
+  // cacheHits holds every match, not just the prefix range's
+  bool cacheComplete;
+  QVector<int> cacheHits;
+  QStringList cacheResult;
+};
+
+#endif
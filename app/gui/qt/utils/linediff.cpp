@@ -0,0 +1,172 @@
+//--
+// This file is part of Sonic Pi: http://sonic-pi.net
+// Full project source: https://github.com/samaaron/sonic-pi
+// License: https://github.com/samaaron/sonic-pi/blob/master/LICENSE.md
+//
+// Copyright 2013, 2014, 2015, 2016 by Sam Aaron (http://sam.aaron.name).
+// All rights reserved.
+//
+// Permission is granted for use, copying, modification, and
+// distribution of modified versions of this work as long as this
+// notice is included.
+//++
+
+#include <QHash>
+#include <algorithm>
+
+#include "linediff.h"
+
+// Beyond this many inserted plus deleted lines the search gives up and
+// reports one hunk, as it takes time proportional to lines times edits.
+static const int MAX_EDITS = 2048;
+
+QStringList splitLines(const QString &text) {
+  QStringList lines;
+  int start = 0;
+  while (start < text.length()) {
+    int end = text.indexOf('\n', start);
+    end = end < 0 ? text.length() : end + 1;
+    lines << text.mid(start, end - start);
+    start = end;
+  }
+  return lines;
+}
+
+static LineDiffHunk hunk(int old_start, int old_count, int new_start, int new_count) {
+  LineDiffHunk h;
+  h.old_start = old_start;
+  h.old_count = old_count;
+  h.new_start = new_start;
+  h.new_count = new_count;
+  return h;
+}
+
+// Adds a hunk, merging it into the last one if they touch, so a
+// deletion next to an insertion reads as one replacement.
+static void addHunk(QVector<LineDiffHunk> &hunks, int old_start, int old_count, int new_start, int new_count) {
+  if (old_count == 0 && new_count == 0) return;
+  if (!hunks.isEmpty()) {
+    LineDiffHunk &last = hunks.last();
+    if (last.old_start + last.old_count == old_start && last.new_start + last.new_count == new_start) {
+      last.old_count += old_count;
+      last.new_count += new_count;
+      return;
+    }
+  }
+  hunks << hunk(old_start, old_count, new_start, new_count);
+}
+
+// Diffs a[0, n) against b[0, m), which start at line a_at and b_at of
+// the whole lists. Rather than keeping every step of the search to walk
+// back through, the search runs from both ends at once until the two
+// meet, then each side of the meeting point is diffed the same way, so
+// only two rows of furthest reaching paths are held at a time.
+static void diffRange(const int *a, int n, const int *b, int m, int a_at, int b_at,
+                      int max_d, QVector<LineDiffHunk> &hunks) {
+  int head = 0;
+  while (head < n && head < m && a[head] == b[head]) head++;
+  a += head; b += head; n -= head; m -= head;
+  a_at += head; b_at += head;
+  while (n > 0 && m > 0 && a[n - 1] == b[m - 1]) {
+    n--;
+    m--;
+  }
+  if (n == 0 || m == 0) {
+    addHunk(hunks, a_at, n, b_at, m);
+    return;
+  }
+
+  // forward[k] and backward[k] are the furthest x reached on diagonal k
+  // from the start and from the end, -1 if not yet reached
+  int steps = std::min((n + m + 1) / 2, max_d);
+  int off = steps + 1;
+  QVector<int> forward(2 * off + 1, -1);
+  QVector<int> backward(2 * off + 1, -1);
+  forward[off + 1] = 0;
+  backward[off + 1] = 0;
+  int delta = n - m;
+  // with an odd delta the paths can only meet on a forward step
+  bool check_forward = (delta & 1) != 0;
+  // diagonals that ran off the bottom or right edge are not extended
+  int f_start = 0, f_end = 0, b_start = 0, b_end = 0;
+  int mid_x = -1;
+  int mid_y = -1;
+
+  for (int d = 0; d < steps && mid_x < 0; d++) {
+    for (int k = -d + f_start; k <= d - f_end && mid_x < 0; k += 2) {
+      int x = (k == -d || (k != d && forward[off + k - 1] < forward[off + k + 1])) ? forward[off + k + 1] : forward[off + k - 1] + 1;
+      int y = x - k;
+      while (x < n && y < m && a[x] == b[y]) {
+        x++;
+        y++;
+      }
+      forward[off + k] = x;
+      if (x > n) {
+        f_end += 2;
+      } else if (y > m) {
+        f_start += 2;
+      } else if (check_forward) {
+        int rk = off + delta - k;
+        if (rk >= 0 && rk < backward.size() && backward[rk] >= 0 && x >= n - backward[rk]) {
+          mid_x = x;
+          mid_y = y;
+        }
+      }
+    }
+    for (int k = -d + b_start; k <= d - b_end && mid_x < 0; k += 2) {
+      int x = (k == -d || (k != d && backward[off + k - 1] < backward[off + k + 1])) ? backward[off + k + 1] : backward[off + k - 1] + 1;
+      int y = x - k;
+      while (x < n && y < m && a[n - 1 - x] == b[m - 1 - y]) {
+        x++;
+        y++;
+      }
+      backward[off + k] = x;
+      if (x > n) {
+        b_end += 2;
+      } else if (y > m) {
+        b_start += 2;
+      } else if (!check_forward) {
+        int fk = off + delta - k;
+        if (fk >= 0 && fk < forward.size() && forward[fk] >= 0 && forward[fk] >= n - x) {
+          mid_x = forward[fk];
+          mid_y = mid_x - (fk - off);
+        }
+      }
+    }
+  }
+
+  if (mid_x < 0) {
+    // too far apart to be worth the search
+    addHunk(hunks, a_at, n, b_at, m);
+    return;
+  }
+  diffRange(a, mid_x, b, mid_y, a_at, b_at, max_d, hunks);
+  diffRange(a + mid_x, n - mid_x, b + mid_y, m - mid_y, a_at + mid_x, b_at + mid_y, max_d, hunks);
+}
+
+QVector<LineDiffHunk> diffLines(const QStringList &from, const QStringList &to) {
+  QVector<LineDiffHunk> hunks;
+
+  // most edits leave the ends of the buffer alone
+  int n = from.size();
+  int m = to.size();
+  int head = 0;
+  while (head < n && head < m && from[head] == to[head]) head++;
+  int tail = 0;
+  while (tail < n - head && tail < m - head && from[n - 1 - tail] == to[m - 1 - tail]) tail++;
+
+  // compare the rest by number rather than by text
+  QHash<QString, int> ids;
+  QVector<int> a, b;
+  for (int i = head; i < n - tail; i++) {
+    a << ids.insert(from[i], ids.value(from[i], ids.size())).value();
+  }
+  for (int j = head; j < m - tail; j++) {
+    b << ids.insert(to[j], ids.value(to[j], ids.size())).value();
+  }
+  if (a.isEmpty() && b.isEmpty()) return hunks;
+
+  // each end of the search covers half the edits
+  diffRange(a.constData(), a.size(), b.constData(), b.size(), head, head, (MAX_EDITS + 1) / 2, hunks);
+  return hunks;
+}
@@ -0,0 +1,40 @@
+//--
+// This file is part of Sonic Pi: http://sonic-pi.net
+// Full project source: https://github.com/samaaron/sonic-pi
+// License: https://github.com/samaaron/sonic-pi/blob/master/LICENSE.md
+//
+// Copyright 2013, 2014, 2015, 2016 by Sam Aaron (http://sam.aaron.name).
+// All rights reserved.
+//
+// Permission is granted for use, copying, modification, and
+// distribution of modified versions of this work as long as this
+// notice is included.
+//++
+
+#ifndef LINEDIFF_H
+#define LINEDIFF_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+// A run of lines that differ: old_count lines from old_start are
+// replaced by new_count lines from new_start.
+struct LineDiffHunk
+{
+  int old_start;
+  int old_count;
+  int new_start;
+  int new_count;
+};
+
+// Splits text into lines, each keeping its trailing newline.
+QStringList splitLines(const QString &text);
+
+// The differing runs between two lists of lines in order, found with
+// Myers' O((N+M)D) algorithm in linear space. Changes with no unchanged
+// line between them come back as one hunk. If the lists differ by more
+// than a few thousand lines the whole differing middle is one hunk.
+QVector<LineDiffHunk> diffLines(const QStringList &from, const QStringList &to);
+
+#endif
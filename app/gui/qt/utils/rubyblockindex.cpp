@@ -0,0 +1,219 @@
+//--
+// This file is part of Sonic Pi: http://sonic-pi.net
+// Full project source: https://github.com/samaaron/sonic-pi
+// License: https://github.com/samaaron/sonic-pi/blob/master/LICENSE.md
+//
+// Copyright 2013, 2014, 2015, 2016 by Sam Aaron (http://sam.aaron.name).
+// All rights reserved.
+//
+// Permission is granted for use, copying, modification, and
+// distribution of modified versions of this work as long as this
+// notice is included.
+//++
+
+#include <algorithm>
+#include <climits>
+
+#include "rubyblockindex.h"
+
+// an empty Scintilla document has a single empty line
+RubyBlockIndex::RubyBlockIndex()
+  : store(1), gap_start(1), gap_len(0), dirty_from(0), dirty_to(0), built_to(0), tree_valid_to(0)
+{
+}
+
+void RubyBlockIndex::moveGap(int line) {
+  while (gap_start > line) {
+    gap_start--;
+    std::swap(store[gap_start], store[gap_start + gap_len]);
+  }
+  while (gap_start < line) {
+    std::swap(store[gap_start], store[gap_start + gap_len]);
+    gap_start++;
+  }
+}
+
+void RubyBlockIndex::insertLines(int line, int count) {
+  moveGap(line);
+  if (gap_len < count) {
+    int grow = std::max(count, store.size());
+    store.insert(gap_start, grow, LineBlocks());
+    gap_len += grow;
+  }
+  for (int i = 0; i < count; i++) {
+    store[gap_start + i] = LineBlocks();
+  }
+  gap_start += count;
+  gap_len -= count;
+}
+
+void RubyBlockIndex::removeLines(int line, int count) {
+  moveGap(line);
+  for (int i = 0; i < count; i++) {
+    store[gap_start + gap_len + i] = LineBlocks();
+  }
+  gap_len += count;
+}
+
+void RubyBlockIndex::markDirty(int from, int to) {
+  if (dirty_from < 0) {
+    dirty_from = from;
+    dirty_to = to;
+  } else {
+    dirty_from = std::min(dirty_from, from);
+    dirty_to = std::max(dirty_to, to);
+  }
+  dirty_to = std::min(dirty_to, lineCount() - 1);
+}
+
+void RubyBlockIndex::linesChanged(int line, int linesAdded) {
+  line = std::max(0, std::min(line, lineCount() - 1));
+  if (linesAdded > 0) {
+    insertLines(line + 1, linesAdded);
+  } else if (linesAdded < 0) {
+    removeLines(line + 1, std::min(-linesAdded, lineCount() - line - 1));
+  }
+
+  // dirty lines after the edit moved with it
+  if (dirty_from >= 0 && dirty_to > line) {
+    dirty_to = std::max(dirty_to + linesAdded, line);
+  }
+  if (dirty_from > line) {
+    dirty_from = std::max(dirty_from + linesAdded, line);
+  }
+  markDirty(line, line + std::max(linesAdded, 0));
+  tree_valid_to = std::min(tree_valid_to, line);
+}
+
+void RubyBlockIndex::rescanLine(int line, const QString &text) {
+  if (line < 0 || line >= lineCount()) return;
+
+  RubyLineState before;
+  if (line > 0) {
+    before.comment_block = entry(line - 1).comment_block;
+    before.quote = entry(line - 1).quote;
+  }
+
+  LineBlocks &e = entry(line);
+  e.start_comment_block = before.comment_block;
+  e.start_quote = before.quote;
+  e.tokens.clear();
+  RubyLineState after = RubyIndenter::scan(text, before, &e.tokens);
+  e.comment_block = after.comment_block;
+  e.quote = after.quote;
+  // with no blocks open the indent is only -1 for the lexical reasons
+  e.verbatim = after.indent < 0;
+
+  if (line == dirty_from) {
+    dirty_from = line < dirty_to ? line + 1 : -1;
+  }
+  // opening or closing a string or comment changes the lines after it
+  if (line + 1 < lineCount()) {
+    const LineBlocks &next = entry(line + 1);
+    if (next.start_comment_block != e.comment_block || next.start_quote != e.quote) {
+      markDirty(line + 1, line + 1);
+    }
+  }
+  tree_valid_to = std::min(tree_valid_to, line);
+}
+
+static bool startsBefore(const RubyBlock &block, int line) {
+  return block.start_line < line;
+}
+
+static bool startsAfter(int line, const RubyBlock &block) {
+  return line < block.start_line;
+}
+
+void RubyBlockIndex::truncateTree(int line) {
+  if (line >= built_to) return;
+  built_to = line;
+
+  // blocks are in start order, so drop those from the first starting
+  // at or after line
+  int keep = std::lower_bound(tree.begin(), tree.end(), line, startsBefore) - tree.begin();
+  tree.resize(keep);
+
+  // the blocks holding line are the innermost one and its parents, and
+  // are open again at that point
+  int b = keep - 1;
+  while (b >= 0 && tree[b].end_line >= 0 && tree[b].end_line < line) {
+    b = tree[b].parent;
+  }
+  open.clear();
+  for (; b >= 0; b = tree[b].parent) {
+    tree[b].end_line = -1;
+    open << b;
+  }
+  std::reverse(open.begin(), open.end());
+}
+
+void RubyBlockIndex::buildTree(int to) {
+  // edits only drop the tree from where they were when it is next used
+  truncateTree(tree_valid_to);
+  tree_valid_to = INT_MAX;
+
+  to = std::min(to, lineCount());
+  for (; built_to < to; built_to++) {
+    int line = built_to;
+    LineBlocks &e = entry(line);
+
+    // follows RubyIndenter::scan, with the level of each open block
+    // standing in for its stack of levels
+    int level = open.isEmpty() ? 0 : tree[open.last()].level + 1;
+    e.indent = e.verbatim ? -1 : level;
+    for (int t = 0; t < e.tokens.size(); t++) {
+      const RubyBlockToken &token = e.tokens[t];
+      if (token.type == RubyBlockToken::Open) {
+        RubyBlock block;
+        block.kind = token.kind;
+        block.name = token.name;
+        block.start_line = line;
+        block.end_line = -1;
+        block.parent = open.isEmpty() ? -1 : open.last();
+        block.depth = open.size();
+        block.level = level;
+        open << tree.size();
+        tree << block;
+        continue;
+      }
+      if (token.type == RubyBlockToken::Close) {
+        if (!open.isEmpty()) {
+          tree[open.last()].end_line = line;
+          open.removeLast();
+        }
+        if (!token.leading) continue;
+        level = open.isEmpty() ? 0 : tree[open.last()].level + 1;
+      } else {
+        level = open.isEmpty() ? 0 : tree[open.last()].level;
+      }
+      if (e.indent >= 0) e.indent = level;
+    }
+  }
+}
+
+int RubyBlockIndex::indentLevel(int line) {
+  if (line < 0 || line >= lineCount()) return 0;
+  buildTree(line + 1);
+  return entry(line).indent;
+}
+
+const QVector<RubyBlock> &RubyBlockIndex::blocks() {
+  buildTree(lineCount());
+  return tree;
+}
+
+int RubyBlockIndex::blockAt(int line, const QString &kind) {
+  const QVector<RubyBlock> &all = blocks();
+
+  // the innermost block holding line is the last that starts at or
+  // before it, or the nearest of its parents that hasn't ended by then
+  int found = std::upper_bound(all.begin(), all.end(), line, startsAfter) - all.begin() - 1;
+  while (found >= 0 && all[found].end_line >= 0 && all[found].end_line < line) {
+    found = all[found].parent;
+  }
+  while (found >= 0 && !kind.isEmpty() && all[found].kind != kind) {
+    found = all[found].parent;
+  }
+  return found;
+}
@@ -0,0 +1,110 @@
+//--
+// This file is part of Sonic Pi: http://sonic-pi.net
+// Full project source: https://github.com/samaaron/sonic-pi
+// License: https://github.com/samaaron/sonic-pi/blob/master/LICENSE.md
+//
+// Copyright 2013, 2014, 2015, 2016 by Sam Aaron (http://sam.aaron.name).
+// All rights reserved.
+//
+// Permission is granted for use, copying, modification, and
+// distribution of modified versions of this work as long as this
+// notice is included.
+//++
+
+#ifndef RUBYBLOCKINDEX_H
+#define RUBYBLOCKINDEX_H
+
+#include <QString>
+#include <QVector>
+
+#include "rubyindenter.h"
+
+// A block in the buffer: a do ... end, a keyword block or a bracket pair.
+struct RubyBlock
+{
+  QString kind;    // eg live_loop, define, with_fx, def, if or {
+  QString name;    // eg :foo, empty if the block has none
+  int start_line;
+  int end_line;    // -1 if the block is never closed
+  int parent;      // index of the enclosing block, -1 at the top level
+  int depth;
+  int level;       // indent level of the line it opens on
+};
+
+// Block structure and indentation of a buffer, kept up to date from
+// edits. The block boundaries of each line are cached, so an edit only
+// rescans the lines it touched, plus any following lines whose meaning
+// it changed by opening or closing a string or =begin comment. The tree
+// is assembled from the cached boundaries as far as it is asked for,
+// and an edit only throws away the part from the edited line on.
+class RubyBlockIndex
+{
+ public:
+  RubyBlockIndex();
+
+  // Records that line was edited with linesAdded lines inserted after
+  // it (or removed if negative), as reported by Scintilla.
+  void linesChanged(int line, int linesAdded);
+
+  // next line that has to be rescanned, -1 when the index is current
+  int nextDirtyLine() const { return dirty_from; }
+  void rescanLine(int line, const QString &text);
+
+  int lineCount() const { return store.size() - gap_len; }
+
+  // Indent level of line, -1 if it should be left as is. Only valid
+  // when there are no dirty lines up to and including it.
+  int indentLevel(int line);
+
+  // Blocks in order of their first line. Only valid when there are no
+  // dirty lines.
+  const QVector<RubyBlock> &blocks();
+
+  // Innermost block containing line, of the given kind if one is
+  // given, or -1.
+  int blockAt(int line, const QString &kind = QString());
+
+ private:
+  struct LineBlocks
+  {
+    LineBlocks() : start_comment_block(false), start_quote(0), comment_block(false), quote(0), verbatim(false), indent(0) {}
+
+    QVector<RubyBlockToken> tokens;
+    // lexical state the line was scanned from, and at its end
+    bool start_comment_block;
+    ushort start_quote;
+    bool comment_block;
+    ushort quote;
+    // starts inside a string or comment, so its indent is left alone
+    bool verbatim;
+    // worked out while assembling the tree
+    int indent;
+  };
+
+  // Lines are kept in a gap buffer, like Scintilla's own per line data,
+  // so inserting or removing lines only moves those between the edit
+  // and the previous one.
+  LineBlocks &entry(int line) { return store[line < gap_start ? line : line + gap_len]; }
+  void moveGap(int line);
+  void insertLines(int line, int count);
+  void removeLines(int line, int count);
+
+  void markDirty(int from, int to);
+  void truncateTree(int line);
+  void buildTree(int to);
+
+  QVector<LineBlocks> store;
+  int gap_start;
+  int gap_len;
+  int dirty_from;
+  int dirty_to;
+
+  // complete for the lines before built_to, with the blocks still
+  // open at that point in open, and unchanged before tree_valid_to
+  QVector<RubyBlock> tree;
+  QVector<int> open;
+  int built_to;
+  int tree_valid_to;
+};
+
+#endif
@@ -0,0 +1,262 @@
+//--
+// This file is part of Sonic Pi: http://sonic-pi.net
+// Full project source: https://github.com/samaaron/sonic-pi
+// License: https://github.com/samaaron/sonic-pi/blob/master/LICENSE.md
+//
+// Copyright 2013, 2014, 2015, 2016 by Sam Aaron (http://sam.aaron.name).
+// All rights reserved.
+//
+// Permission is granted for use, copying, modification, and
+// distribution of modified versions of this work as long as this
+// notice is included.
+//++
+
+#include <cstring>
+
+#include "rubyindenter.h"
+
+static bool isWordChar(QChar c) {
+  return c.isLetterOrNumber() || c == '_';
+}
+
+static bool charIn(QChar c, const char *set) {
+  char l = c.toLatin1();
+  return l && strchr(set, l);
+}
+
+static bool wordIs(const QChar *word, int len, const char *keyword) {
+  int n = (int)strlen(keyword);
+  if (n != len) return false;
+  for (int i = 0; i < n; i++) {
+    if (word[i] != QLatin1Char(keyword[i])) return false;
+  }
+  return true;
+}
+
+static bool wordIsOneOf(const QChar *word, int len, const char *const *keywords) {
+  for (; *keywords; keywords++) {
+    if (wordIs(word, len, *keywords)) return true;
+  }
+  return false;
+}
+
+// keywords that open a block wherever they appear
+static const char *const BLOCK_KEYWORDS[] = { "def", "class", "module", "case", "begin", 0 };
+// keywords that only open a block at the start of a statement,
+// otherwise they are modifiers
+static const char *const STATEMENT_KEYWORDS[] = { "if", "unless", "while", "until", "for", 0 };
+// keywords followed by the name of what they define
+static const char *const NAMED_KEYWORDS[] = { "def", "class", "module", 0 };
+// keywords that take an optional do on the same line
+static const char *const LOOP_KEYWORDS[] = { "while", "until", "for", 0 };
+// keywords lined up with the opener when they start a line
+static const char *const MIDDLE_KEYWORDS[] = { "else", "elsif", "when", "rescue", "ensure", 0 };
+// keywords after which a new statement starts
+static const char *const LEAD_KEYWORDS[] = { "then", "do", "else", "begin", 0 };
+
+static ushort closingDelimiter(ushort open) {
+  switch (open) {
+  case '(': return ')';
+  case '[': return ']';
+  case '{': return '}';
+  case '<': return '>';
+  }
+  return open;
+}
+
+// Returns the index just after the closing delimiter, or -1 if the
+// string runs past the end of the line.
+static int skipString(const QChar *c, int n, int i, ushort close) {
+  for (; i < n; i++) {
+    if (c[i] == '\\') {
+      i++;
+    } else if (c[i].unicode() == close) {
+      return i + 1;
+    }
+  }
+  return -1;
+}
+
+RubyLineState RubyIndenter::scan(const QString &text, const RubyLineState &before,
+                                 QVector<RubyBlockToken> *tokens) {
+  RubyLineState s = before;
+  const QChar *c = text.constData();
+  int n = text.length();
+
+  if (s.comment_block) {
+    s.indent = -1;
+    if (text.startsWith("=end")) s.comment_block = false;
+    return s;
+  }
+  if (text.startsWith("=begin")) {
+    s.comment_block = true;
+    s.indent = -1;
+    return s;
+  }
+
+  int i = 0;
+  // a line that starts inside a string is left alone
+  bool leading = true;
+  int level = s.open.isEmpty() ? 0 : s.open.last() + 1;
+  s.indent = level;
+  if (s.quote) {
+    i = skipString(c, n, 0, s.quote);
+    if (i < 0) {
+      s.indent = -1;
+      return s;
+    }
+    s.quote = 0;
+    s.indent = -1;
+    leading = false;
+  }
+
+  bool statement = true;
+  bool loop = false;
+
+  // for naming blocks: the method a do block is passed to, its first
+  // symbol or string argument, and a def still waiting for its name
+  QString call;
+  QString arg;
+  int naming = -1;
+  auto record = [&](RubyBlockToken::Type type, int column, const QString &kind, const QString &name) {
+    if (!tokens) return;
+    RubyBlockToken t;
+    t.type = type;
+    t.column = column;
+    t.leading = leading;
+    t.kind = kind;
+    t.name = name;
+    *tokens << t;
+  };
+
+  while (i < n) {
+    QChar ch = c[i];
+    if (ch.isSpace()) {
+      i++;
+      continue;
+    }
+    if (ch == '#') break;
+
+    // closers at the start of the line pull it back to their opener
+    if (ch == ')' || ch == ']' || ch == '}') {
+      if (!s.open.isEmpty()) s.open.removeLast();
+      record(RubyBlockToken::Close, i, QString(ch), QString());
+      if (leading) {
+        level = s.open.isEmpty() ? 0 : s.open.last() + 1;
+        if (s.indent >= 0) s.indent = level;
+      }
+      statement = false;
+      i++;
+      continue;
+    }
+
+    if (isWordChar(ch) && !ch.isDigit()) {
+      int start = i;
+      while (i < n && isWordChar(c[i])) i++;
+      if (i < n && (c[i] == '?' || c[i] == '!')) i++;
+      const QChar *word = c + start;
+      int len = i - start;
+      QString w = tokens ? QString(word, len) : QString();
+
+      // :symbols, .method calls and key: args are never keywords
+      bool symbol = start > 0 && c[start - 1] == ':' && !(start > 1 && c[start - 2] == ':');
+      bool method = start > 0 && c[start - 1] == '.';
+      bool key = i < n && c[i] == ':' && !(i + 1 < n && c[i + 1] == ':');
+      if (symbol || method || key) {
+        if (naming >= 0) {
+          (*tokens)[naming].name = w;
+          naming = -1;
+        } else if (method) {
+          call = w;
+        } else if (symbol && !call.isEmpty() && arg.isEmpty()) {
+          arg = ":" + w;
+        }
+        leading = false;
+        statement = false;
+        continue;
+      }
+
+      if (wordIs(word, len, "end")) {
+        if (!s.open.isEmpty()) s.open.removeLast();
+        record(RubyBlockToken::Close, start, w, QString());
+        if (leading) {
+          level = s.open.isEmpty() ? 0 : s.open.last() + 1;
+          if (s.indent >= 0) s.indent = level;
+        }
+        statement = false;
+        continue;
+      }
+
+      if (leading && wordIsOneOf(word, len, MIDDLE_KEYWORDS)) {
+        level = s.open.isEmpty() ? 0 : s.open.last();
+        if (s.indent >= 0) s.indent = level;
+        record(RubyBlockToken::Middle, start, w, QString());
+      }
+      leading = false;
+
+      if (wordIs(word, len, "do")) {
+        // the do of while x do belongs to the while
+        if (!loop) {
+          s.open << level;
+          record(RubyBlockToken::Open, start, call.isEmpty() ? w : call, arg);
+        }
+        loop = false;
+      } else if (wordIsOneOf(word, len, BLOCK_KEYWORDS) ||
+                 (statement && wordIsOneOf(word, len, STATEMENT_KEYWORDS))) {
+        s.open << level;
+        loop = wordIsOneOf(word, len, LOOP_KEYWORDS);
+        record(RubyBlockToken::Open, start, w, QString());
+        if (tokens && wordIsOneOf(word, len, NAMED_KEYWORDS)) naming = tokens->size() - 1;
+      } else if (naming >= 0) {
+        (*tokens)[naming].name = w;
+        naming = -1;
+      } else if (statement && !wordIsOneOf(word, len, LEAD_KEYWORDS)) {
+        call = w;
+        arg.clear();
+      }
+
+      statement = wordIsOneOf(word, len, LEAD_KEYWORDS);
+      continue;
+    }
+
+    leading = false;
+
+    if (ch == '"' || ch == '\'' || ch == '`' ||
+        (ch == '%' && i + 2 < n && charIn(c[i + 1], "wWiIqQ") &&
+         !isWordChar(c[i + 2]) && !c[i + 2].isSpace())) {
+      int start = i;
+      int from = ch == '%' ? i + 3 : i + 1;
+      ushort close = closingDelimiter(c[from - 1].unicode());
+      i = skipString(c, n, from, close);
+      if (i < 0) {
+        s.quote = close;
+        break;
+      }
+      if (tokens && !call.isEmpty() && arg.isEmpty()) arg = QString(c + start, i - start);
+      statement = false;
+      continue;
+    }
+
+    if (ch == '(' || ch == '[' || ch == '{') {
+      s.open << level;
+      record(RubyBlockToken::Open, i, QString(ch), QString());
+      statement = ch == '(';
+      i++;
+      continue;
+    }
+
+    if (ch == ';') {
+      statement = true;
+    } else if (ch == '=') {
+      // assignment, but not == =~ => or the tail of <= >= !=
+      bool before = i > 0 && charIn(c[i - 1], "=!<>");
+      bool after = i + 1 < n && charIn(c[i + 1], "=~>");
+      statement = !before && !after;
+    } else {
+      statement = false;
+    }
+    i++;
+  }
+
+  return s;
+}
@@ -0,0 +1,55 @@
+//--
+// This file is part of Sonic Pi: http://sonic-pi.net
+// Full project source: https://github.com/samaaron/sonic-pi
+// License: https://github.com/samaaron/sonic-pi/blob/master/LICENSE.md
+//
+// Copyright 2013, 2014, 2015, 2016 by Sam Aaron (http://sam.aaron.name).
+// All rights reserved.
+//
+// Permission is granted for use, copying, modification, and
+// distribution of modified versions of this work as long as this
+// notice is included.
+//++
+
+#ifndef RUBYINDENTER_H
+#define RUBYINDENTER_H
+
+#include <QString>
+#include <QVector>
+
+// What the indenter knows at the end of one line of Ruby.
+struct RubyLineState
+{
+  RubyLineState() : comment_block(false), quote(0), indent(0) {}
+
+  QVector<int> open;   // indent level of the line holding each unclosed opener
+  bool comment_block;  // inside =begin ... =end
+  ushort quote;        // closing delimiter of a string still open, 0 if none
+  int indent;          // level the line itself should be at, -1 to leave it alone
+};
+
+// A block boundary found while scanning a line.
+struct RubyBlockToken
+{
+  enum Type { Open, Middle, Close };
+
+  Type type;
+  int column;
+  bool leading;  // nothing but other closers before it on the line
+  QString kind;  // the keyword or bracket, or for a do block the method it is passed to
+  QString name;  // first symbol or string argument, eg :foo for live_loop :foo
+};
+
+// Works out Ruby block indentation line by line, following the same
+// rules as the server's beautifier closely enough for newline and
+// indent. RubyBlockIndex keeps the result of each line for the editor.
+class RubyIndenter
+{
+ public:
+  // Scans one line given the state after the line before it, adding
+  // any block boundaries to tokens if given.
+  static RubyLineState scan(const QString &text, const RubyLineState &before,
+                            QVector<RubyBlockToken> *tokens = 0);
+};
+
+#endif
@@ -14,6 +14,7 @@
 
 #include <QDir>
 #include <iostream>
+#include <algorithm>
 
 #include "sonicpiapis.h"
 
@@ -23,6 +24,10 @@ using namespace std;
 SonicPiAPIs::SonicPiAPIs(QsciLexer *lexer)
     : QsciAbstractAPIs(lexer)
 {
+  for (int ctx = 0; ctx < NContext; ctx++) {
+    revision[ctx] = 0;
+  }
+
   // manually managed for now
   keywords[Chord] << "'1'" << "'5'" << "'+5'" << "'m+5'" << ":sus2" << ":sus4" << "'6'" << ":m6" << "'7sus2'" << "'7sus4'" << "'7-5'" << ":halfdiminished" << "'7+5'" << "'m7+5'" << "'9'" << ":m9" << "'m7+9'" << ":maj9" << "'9sus4'" << "'6*9'" << "'m6*9'" << "'7-9'" << "'m7-9'" << "'7-10'" << "'7-11'" << "'7-13'" << "'9+5'" << "'m9+5'" << "'7+5-9'" << "'m7+5-9'" << "'11'" << ":m11" << ":maj11" << "'11+'" << "'m11+'" << "'13'" << ":m13" << ":add2" << ":add4" << ":add9" << ":add11" << ":add13" << ":madd2" << ":madd4" << ":madd9" << ":madd11" << ":madd13" << ":major" << ":maj" << ":M" << ":minor" << ":min" << ":m" << ":major7" << ":dom7" << "'7'" << ":M7" << ":minor7" << ":m7" << ":augmented" << ":a" << ":diminished" << ":dim" << ":i" << ":diminished7" << ":dim7" << ":i7" << ":halfdim" << "'m7b5'" << "'m7-5'";
 
@@ -40,6 +45,10 @@ SonicPiAPIs::SonicPiAPIs(QsciLexer *lexer)
   keywords[Tuning] << ":just" << ":pythagorean" << ":meantone" << ":equal";
 
   keywords[MidiParam] << "sustain:" << "velocity:" << "vel:" << "velocity_f:" << "vel_f:" << "port:" << "channel:";
+
+  for (int ctx = 0; ctx < NContext; ctx++) {
+    sortKeywords(ctx);
+  }
 }
 
 
@@ -51,9 +60,12 @@ void SonicPiAPIs::loadSamples(QString sample_path) {
   dir.setNameFilters(filetypes);
 
   QFileInfoList files = dir.entryInfoList(QDir::Files | QDir::NoDotAndDotDot);
+  // append the whole directory and sort once rather than inserting
+  // each sample into place
   foreach (QFileInfo file, files) {
-    addSymbol(Sample, file.baseName());
+    keywords[Sample] << QString(":" + file.baseName());
   }
+  sortKeywords(Sample);
 }
 
 void SonicPiAPIs::addSymbol(int context, QString sym) {
@@ -61,7 +73,7 @@ void SonicPiAPIs::addSymbol(int context, QString sym) {
 }
 
 void SonicPiAPIs::addKeyword(int context, QString keyword) {
-  keywords[context] << keyword;
+  insertKeyword(context, keyword);
 }
 
 void SonicPiAPIs::addFXArgs(QString fx, QStringList args) {
@@ -73,12 +85,72 @@ void SonicPiAPIs::addSynthArgs(QString fx, QStringList args) {
 }
 
 void SonicPiAPIs::addCuePath(QString path) {
-  keywords[CuePath] << path;
+  insertKeyword(CuePath, path);
+}
+
+void SonicPiAPIs::insertKeyword(int context, const QString &keyword) {
+  QStringList &words = keywords[context];
+  QStringList::iterator pos = std::lower_bound(words.begin(), words.end(), keyword);
+  if (pos == words.end() || *pos != keyword) {
+    int idx = pos - words.begin();
+    words.insert(pos, keyword);
+    keywordMasks[context].insert(idx, FuzzyMatcher::charMask(keyword));
+    revision[context]++;
+  }
+}
+
+void SonicPiAPIs::sortKeywords(int context) {
+  QStringList &words = keywords[context];
+  std::sort(words.begin(), words.end());
+  words.erase(std::unique(words.begin(), words.end()), words.end());
+
+  QVector<quint64> &masks = keywordMasks[context];
+  masks.resize(words.size());
+  for (int i = 0; i < words.size(); i++) {
+    masks[i] = FuzzyMatcher::charMask(words[i]);
+  }
+  revision[context]++;
+}
+
+void SonicPiAPIs::noteCompletion(QString word) {
+  matcher.noteUsed(word);
 }
 
+// The editor runs with AcsNone and pops up rankedCompletions() itself,
+// so QScintilla only calls this if its own autocompletion is turned
+// back on.
 void SonicPiAPIs::updateAutoCompletionList(const QStringList &context,
 					   QStringList &list) {
-  if (context.isEmpty()) return;
+  list << rankedCompletions(context);
+}
+
+QStringList SonicPiAPIs::rankedCompletions(const QStringList &context) {
+  QStringList list;
+  if (context.isEmpty()) return list;
+
+  QString partial = context.last();
+  int ctx = completionContext(context, list);
+  if (ctx < 0) {
+    // fx and synth params are short lists, rank them directly
+    return matcher.rank(partial, list);
+  }
+
+  // every word starting with partial sorts at or after partial itself
+  // and before the first word that doesn't share the prefix
+  const QStringList &words = keywords[ctx];
+  int first = std::lower_bound(words.constBegin(), words.constEnd(), partial) - words.constBegin();
+  int last = first;
+  while (last < words.size() && words[last].startsWith(partial)) {
+    last++;
+  }
+  return matcher.rank(ctx, revision[ctx], partial, words, keywordMasks[ctx], first, last);
+}
+
+// Works out which keyword set to complete from. Returns -1 when there
+// is nothing to offer or list has already been filled in.
+int SonicPiAPIs::completionContext(const QStringList &context,
+				   QStringList &list) {
+  if (context.isEmpty()) return -1;
 
   // default
   int ctx = Func;
@@ -133,52 +205,44 @@ void SonicPiAPIs::updateAutoCompletionList(const QStringList &context,
   // FX params
   } else if (words.length() >= 2 &&
              (first == "with_fx")) {
-    if (last.endsWith(':')) return; // don't try to complete parameters
+    if (last.endsWith(':')) return -1; // don't try to complete parameters
     if (fxArgs.contains(second)) {
       list = fxArgs[second];
-      return;
+      return -1;
     }
 
   // Synth params
   } else if (words.length() >= 2 && first == "synth") {
-    if (last.endsWith(':')) return; // don't try to complete parameters
+    if (last.endsWith(':')) return -1; // don't try to complete parameters
     if (synthArgs.contains(second)) {
       list = synthArgs[second];
-      return;
+      return -1;
     }
 
   // Play params
   } else if (words.length() >= 2 && first == "play") {
-    if (last.endsWith(':')) return; // don't try to complete parameters
+    if (last.endsWith(':')) return -1; // don't try to complete parameters
     ctx = PlayParam;
 
   // Sample params
   } else if (words.length() >= 2 && first == "sample") {
-    if (last.endsWith(':')) return; // don't try to complete parameters
+    if (last.endsWith(':')) return -1; // don't try to complete parameters
     ctx = SampleParam;
   } else if (first == "use_sample_defaults" || first == "with_sample_defaults") {
-    if (last.endsWith(':')) return; // don't try to complete parameters
+    if (last.endsWith(':')) return -1; // don't try to complete parameters
     ctx = SampleParam;
   } else if (words.length() >= 2 && first == "midi") {
-    if (last.endsWith(':')) return; // don't try to complete parameters
+    if (last.endsWith(':')) return -1; // don't try to complete parameters
     ctx = MidiParam;
   } else if (context.length() > 1) {
     if (partial.length() <= 2) {
       // don't attempt to autocomplete other words on the same line
       // unless we have a plausible match
-      return;
+      return -1;
     }
   }
 
-  if (partial == "") {
-    list << keywords[ctx];
-  } else {
-    foreach (const QString &str, keywords[ctx]) {
-      if (str.startsWith(partial)) {
-	list << str;
-      }
-    }
-  }
+  return ctx;
 }
 
 QStringList SonicPiAPIs::callTips(const QStringList &context, int commas, QsciScintilla::CallTipsStyle style, QList<int> &shifts) {
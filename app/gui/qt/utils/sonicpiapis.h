@@ -13,6 +13,9 @@
 
 #include <Qsci/qsciabstractapis.h>
 #include <QHash>
+#include <QVector>
+
+#include "fuzzymatcher.h"
 
 class SonicPiAPIs : public QsciAbstractAPIs
 {
@@ -37,9 +40,24 @@ class SonicPiAPIs : public QsciAbstractAPIs
 			       QsciScintilla::CallTipsStyle style,
 			       QList<int> &shifts);
 
+  // Completions for the word being typed, best fuzzy match first.
+  QStringList rankedCompletions(const QStringList &context);
+  // Lets recently chosen completions rank higher.
+  void noteCompletion(QString word);
+
 
  private:
+  int completionContext(const QStringList &context, QStringList &list);
+  void insertKeyword(int context, const QString &keyword);
+  void sortKeywords(int context);
+
+  // each context is kept sorted and free of duplicates so that all the
+  // completions of a prefix sit in one contiguous range
   QStringList keywords[NContext];
+  // charMask of each keyword, in the same order
+  QVector<quint64> keywordMasks[NContext];
+  unsigned int revision[NContext];
+  FuzzyMatcher matcher;
   QHash<QString, QStringList> fxArgs;
   QHash<QString, QStringList> synthArgs;
 };
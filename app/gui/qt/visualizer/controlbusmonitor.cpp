@@ -0,0 +1,142 @@
+//--
+// This file is part of Sonic Pi: http://sonic-pi.net
+// Full project source: https://github.com/samaaron/sonic-pi
+// License: https://github.com/samaaron/sonic-pi/blob/master/LICENSE.md
+//
+// Copyright 2013, 2014, 2015, 2016 by Sam Aaron (http://sam.aaron.name).
+// All rights reserved.
+//
+// Permission is granted for use, copying, modification, and
+// distribution of modified versions of this work as long as this
+// notice is included.
+//++
+
+#include "controlbusmonitor.h"
+
+#include <QLineEdit>
+#include <QVBoxLayout>
+#include <QPainter>
+#include <QPaintEvent>
+#include <QRegExp>
+#include <algorithm>
+
+ControlBusMonitor::ControlBusMonitor( QWidget* parent ) : QWidget(parent), color("deeppink")
+{
+  busEdit = new QLineEdit(this);
+  busEdit->setPlaceholderText(tr("Control buses to watch, e.g. 0 1 2"));
+  busEdit->setToolTip(tr("Up to %1 control bus numbers between 0 and %2,\nseparated by spaces or commas.").arg((int)ControlBusReading::MAX_BUSES).arg((int)MAX_BUS));
+  connect(busEdit, SIGNAL(editingFinished()), this, SLOT(parseBuses()));
+
+  QVBoxLayout* layout = new QVBoxLayout();
+  layout->setContentsMargins(0,0,0,0);
+  layout->addWidget(busEdit);
+  layout->addStretch(1);
+  setLayout(layout);
+  setSizePolicy(QSizePolicy::MinimumExpanding, QSizePolicy::Preferred);
+}
+
+QSize ControlBusMonitor::sizeHint() const
+{
+  int rows = std::max(1, (int)watched.size());
+  return QSize(200, busEdit->sizeHint().height() + rows * (fontMetrics().height() + 4) + 4);
+}
+
+void ControlBusMonitor::setColor( QColor c )
+{
+  color = c;
+  update();
+}
+
+void ControlBusMonitor::parseBuses()
+{
+  std::vector<int> buses;
+  for( const QString& part : busEdit->text().split(QRegExp("[\\s,]+"), QString::SkipEmptyParts) )
+  {
+    bool ok = false;
+    int bus = part.toInt(&ok);
+    if( ok && bus >= 0 && bus <= MAX_BUS && std::find(buses.begin(), buses.end(), bus) == buses.end() && buses.size() < ControlBusReading::MAX_BUSES )
+    {
+      buses.push_back(bus);
+    }
+  }
+  if( buses == watched ) return;
+
+  watched = buses;
+  traces.assign(watched.size(), Trace());
+  for( Trace& t : traces )
+  {
+    t.values.assign(HISTORY, 0.0f);
+    t.pos = 0;
+    t.count = 0;
+  }
+  updateGeometry();
+  update();
+  emit busesChanged();
+}
+
+void ControlBusMonitor::addReading( const ControlBusReading& reading )
+{
+  // readings taken before a change of buses are dropped
+  for( unsigned int i = 0; i < watched.size(); ++i )
+  {
+    if( reading.bus[i] != watched[i] ) return;
+  }
+  for( unsigned int i = 0; i < watched.size(); ++i )
+  {
+    Trace& t = traces[i];
+    t.values[t.pos] = reading.value[i];
+    t.pos = (t.pos + 1) % HISTORY;
+    t.count = std::min(t.count + 1, (unsigned int)HISTORY);
+  }
+  update();
+}
+
+void ControlBusMonitor::paintEvent( QPaintEvent* event )
+{
+  Q_UNUSED(event);
+  if( watched.empty() ) return;
+
+  QPainter p(this);
+  QFontMetrics fm = fontMetrics();
+  int row_h = fm.height() + 4;
+  int label_w = fm.width("bus 000") + 6;
+  int value_w = fm.width("-00000.000") + 6;
+  int top = busEdit->geometry().bottom() + 4;
+  int spark_w = width() - label_w - value_w;
+  QColor dim = color;
+  dim.setAlpha(60);
+
+  QPolygonF line;
+  for( unsigned int i = 0; i < watched.size(); ++i )
+  {
+    const Trace& t = traces[i];
+    int y = top + i * row_h;
+    p.setPen(color);
+    p.drawText(QRect(0, y, label_w, row_h), Qt::AlignVCenter | Qt::AlignLeft, QString("bus %1").arg(watched[i]));
+    if( t.count == 0 ) continue;
+
+    unsigned int first = (t.pos + HISTORY - t.count) % HISTORY;
+    float latest = t.values[(t.pos + HISTORY - 1) % HISTORY];
+    p.drawText(QRect(width() - value_w, y, value_w, row_h), Qt::AlignVCenter | Qt::AlignRight, QString::number(latest, 'g', 5));
+
+    // each sparkline is scaled to its own range so small wobbles show
+    float mn = t.values[first], mx = mn;
+    for( unsigned int k = 1; k < t.count; ++k )
+    {
+      float v = t.values[(first + k) % HISTORY];
+      mn = std::min(mn, v);
+      mx = std::max(mx, v);
+    }
+    float range = mx > mn ? mx - mn : 1.0f;
+
+    QRectF area(label_w, y + 2, spark_w, row_h - 4);
+    p.fillRect(area, dim);
+    line.resize(t.count);
+    for( unsigned int k = 0; k < t.count; ++k )
+    {
+      float v = t.values[(first + k) % HISTORY];
+      line[k] = QPointF(area.left() + area.width() * k / (HISTORY - 1), area.bottom() - (v - mn) / range * area.height());
+    }
+    p.drawPolyline(line);
+  }
+}
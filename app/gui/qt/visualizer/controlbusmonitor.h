@@ -0,0 +1,73 @@
+//--
+// This file is part of Sonic Pi: http://sonic-pi.net
+// Full project source: https://github.com/samaaron/sonic-pi
+// License: https://github.com/samaaron/sonic-pi/blob/master/LICENSE.md
+//
+// Copyright 2013, 2014, 2015, 2016 by Sam Aaron (http://sam.aaron.name).
+// All rights reserved.
+//
+// Permission is granted for use, copying, modification, and
+// distribution of modified versions of this work as long as this
+// notice is included.
+//++
+
+#ifndef CONTROLBUSMONITOR_H
+#define CONTROLBUSMONITOR_H
+
+#include <QWidget>
+#include <vector>
+
+class QLineEdit;
+
+// Values of the watched control buses, read straight from scsynth's
+// shared memory by the scope thread. Unused slots have a bus of -1.
+struct ControlBusReading
+{
+  enum { MAX_BUSES = 8 };
+  int bus[MAX_BUSES];
+  float value[MAX_BUSES];
+  unsigned long sequence;
+};
+
+// Shows a handful of control buses as numbers and sparklines of their
+// recent history, without any OSC traffic.
+class ControlBusMonitor : public QWidget
+{
+  Q_OBJECT
+public:
+  // Only the first 128 buses are offered as that is all scsynth
+  // allocates on the Raspberry Pi.
+  enum { MAX_BUS = 127, HISTORY = 256 };
+
+  explicit ControlBusMonitor( QWidget* parent = 0 );
+
+  const std::vector<int>& buses() const { return watched; }
+  void addReading( const ControlBusReading& reading );
+  void setColor( QColor c );
+
+  QSize sizeHint() const;
+
+signals:
+  void busesChanged();
+
+protected:
+  void paintEvent( QPaintEvent* event );
+
+private slots:
+  void parseBuses();
+
+private:
+  struct Trace
+  {
+    std::vector<float> values;
+    unsigned int pos;
+    unsigned int count;
+  };
+
+  QLineEdit* busEdit;
+  std::vector<int> watched;
+  std::vector<Trace> traces;
+  QColor color;
+};
+
+#endif
@@ -0,0 +1,498 @@
+//--
+// This file is part of Sonic Pi: http://sonic-pi.net
+// Full project source: https://github.com/samaaron/sonic-pi
+// License: https://github.com/samaaron/sonic-pi/blob/master/LICENSE.md
+//
+// Copyright 2013, 2014, 2015, 2016 by Sam Aaron (http://sam.aaron.name).
+// All rights reserved.
+//
+// Permission is granted for use, copying, modification, and
+// distribution of modified versions of this work as long as this
+// notice is included.
+//++
+
+#include "dspkernels.h"
+
+#include <cmath>
+#include <cstring>
+#include <vector>
+#include <iostream>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__)
+  #define DSP_HAVE_SSE2
+  #include <emmintrin.h>
+  #if defined(__GNUC__)
+    // compiled for AVX2 per function so the rest of the app still runs
+    // on older CPUs
+    #define DSP_HAVE_AVX2
+    #include <immintrin.h>
+  #endif
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+  #define DSP_HAVE_NEON
+  #include <arm_neon.h>
+  // 32 bit ARM has no double lanes, so only peak is vectorised there
+  // (e.g. on a Raspberry Pi running a 32 bit OS)
+  #if defined(__aarch64__)
+    #define DSP_HAVE_NEON64
+  #endif
+#endif
+
+// Scalar reference
+
+static void widenScalar( const float* src, double* dst, unsigned int n )
+{
+  for( unsigned int i = 0; i < n; ++i )
+  {
+    dst[i] = src[i];
+  }
+}
+
+static void monoRmsScalar( const float* left, const float* right, double* dst, unsigned int n )
+{
+  for( unsigned int i = 0; i < n; ++i )
+  {
+    double dl = left[i] + 1.0;
+    double dr = right[i] + 1.0;
+    dst[i] = std::sqrt((dl*dl + dr*dr) * 0.5) - 1.0;
+  }
+}
+
+static float peakScalar( const float* src, unsigned int n )
+{
+  float peak = 0.0f;
+  for( unsigned int i = 0; i < n; ++i )
+  {
+    float a = std::fabs(src[i]);
+    if( a > peak ) peak = a;
+  }
+  return peak;
+}
+
+static void minMaxScalar( const double* src, unsigned int n, double* min_out, double* max_out )
+{
+  if( n == 0 ) return;
+  double mn = src[0];
+  double mx = src[0];
+  for( unsigned int i = 1; i < n; ++i )
+  {
+    if( src[i] < mn ) mn = src[i];
+    if( src[i] > mx ) mx = src[i];
+  }
+  *min_out = mn;
+  *max_out = mx;
+}
+
+static void butterflyScalar( double* a_re, double* a_im, double* b_re, double* b_im,
+                             const double* w_re, const double* w_im, unsigned int n )
+{
+  for( unsigned int j = 0; j < n; ++j )
+  {
+    double t_re = b_re[j] * w_re[j] - b_im[j] * w_im[j];
+    double t_im = b_re[j] * w_im[j] + b_im[j] * w_re[j];
+    b_re[j] = a_re[j] - t_re;
+    b_im[j] = a_im[j] - t_im;
+    a_re[j] += t_re;
+    a_im[j] += t_im;
+  }
+}
+
+#ifdef DSP_HAVE_SSE2
+
+static void widenSse2( const float* src, double* dst, unsigned int n )
+{
+  unsigned int i = 0;
+  for( ; i + 4 <= n; i += 4 )
+  {
+    __m128 f = _mm_loadu_ps(src + i);
+    _mm_storeu_pd(dst + i, _mm_cvtps_pd(f));
+    _mm_storeu_pd(dst + i + 2, _mm_cvtps_pd(_mm_movehl_ps(f, f)));
+  }
+  widenScalar(src + i, dst + i, n - i);
+}
+
+static inline __m128d monoRmsSse2Pair( __m128d l, __m128d r )
+{
+  const __m128d one = _mm_set1_pd(1.0);
+  const __m128d half = _mm_set1_pd(0.5);
+  l = _mm_add_pd(l, one);
+  r = _mm_add_pd(r, one);
+  __m128d sum = _mm_add_pd(_mm_mul_pd(l, l), _mm_mul_pd(r, r));
+  return _mm_sub_pd(_mm_sqrt_pd(_mm_mul_pd(sum, half)), one);
+}
+
+static void monoRmsSse2( const float* left, const float* right, double* dst, unsigned int n )
+{
+  unsigned int i = 0;
+  for( ; i + 4 <= n; i += 4 )
+  {
+    __m128 l = _mm_loadu_ps(left + i);
+    __m128 r = _mm_loadu_ps(right + i);
+    _mm_storeu_pd(dst + i, monoRmsSse2Pair(_mm_cvtps_pd(l), _mm_cvtps_pd(r)));
+    _mm_storeu_pd(dst + i + 2, monoRmsSse2Pair(_mm_cvtps_pd(_mm_movehl_ps(l, l)), _mm_cvtps_pd(_mm_movehl_ps(r, r))));
+  }
+  monoRmsScalar(left + i, right + i, dst + i, n - i);
+}
+
+static float peakSse2( const float* src, unsigned int n )
+{
+  const __m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+  __m128 peak = _mm_setzero_ps();
+  unsigned int i = 0;
+  for( ; i + 4 <= n; i += 4 )
+  {
+    peak = _mm_max_ps(peak, _mm_and_ps(_mm_loadu_ps(src + i), abs_mask));
+  }
+  float lanes[4];
+  _mm_storeu_ps(lanes, peak);
+  float result = peakScalar(src + i, n - i);
+  for( int j = 0; j < 4; ++j )
+  {
+    if( lanes[j] > result ) result = lanes[j];
+  }
+  return result;
+}
+
+static void minMaxSse2( const double* src, unsigned int n, double* min_out, double* max_out )
+{
+  if( n < 8 )
+  {
+    minMaxScalar(src, n, min_out, max_out);
+    return;
+  }
+  // two accumulators of two lanes each to hide the latency
+  __m128d mn0 = _mm_loadu_pd(src), mn1 = _mm_loadu_pd(src + 2);
+  __m128d mx0 = mn0, mx1 = mn1;
+  unsigned int i = 4;
+  for( ; i + 4 <= n; i += 4 )
+  {
+    __m128d v0 = _mm_loadu_pd(src + i);
+    __m128d v1 = _mm_loadu_pd(src + i + 2);
+    mn0 = _mm_min_pd(mn0, v0);
+    mn1 = _mm_min_pd(mn1, v1);
+    mx0 = _mm_max_pd(mx0, v0);
+    mx1 = _mm_max_pd(mx1, v1);
+  }
+  double lanes_min[4], lanes_max[4];
+  _mm_storeu_pd(lanes_min, mn0);
+  _mm_storeu_pd(lanes_min + 2, mn1);
+  _mm_storeu_pd(lanes_max, mx0);
+  _mm_storeu_pd(lanes_max + 2, mx1);
+  double rmin = lanes_min[0], rmax = lanes_max[0];
+  for( int j = 1; j < 4; ++j )
+  {
+    if( lanes_min[j] < rmin ) rmin = lanes_min[j];
+    if( lanes_max[j] > rmax ) rmax = lanes_max[j];
+  }
+  for( ; i < n; ++i )
+  {
+    if( src[i] < rmin ) rmin = src[i];
+    if( src[i] > rmax ) rmax = src[i];
+  }
+  *min_out = rmin;
+  *max_out = rmax;
+}
+
+static void butterflySse2( double* a_re, double* a_im, double* b_re, double* b_im,
+                           const double* w_re, const double* w_im, unsigned int n )
+{
+  unsigned int j = 0;
+  for( ; j + 2 <= n; j += 2 )
+  {
+    __m128d br = _mm_loadu_pd(b_re + j);
+    __m128d bi = _mm_loadu_pd(b_im + j);
+    __m128d wr = _mm_loadu_pd(w_re + j);
+    __m128d wi = _mm_loadu_pd(w_im + j);
+    __m128d ar = _mm_loadu_pd(a_re + j);
+    __m128d ai = _mm_loadu_pd(a_im + j);
+    __m128d tr = _mm_sub_pd(_mm_mul_pd(br, wr), _mm_mul_pd(bi, wi));
+    __m128d ti = _mm_add_pd(_mm_mul_pd(br, wi), _mm_mul_pd(bi, wr));
+    _mm_storeu_pd(b_re + j, _mm_sub_pd(ar, tr));
+    _mm_storeu_pd(b_im + j, _mm_sub_pd(ai, ti));
+    _mm_storeu_pd(a_re + j, _mm_add_pd(ar, tr));
+    _mm_storeu_pd(a_im + j, _mm_add_pd(ai, ti));
+  }
+  butterflyScalar(a_re + j, a_im + j, b_re + j, b_im + j, w_re + j, w_im + j, n - j);
+}
+
+#endif
+
+#ifdef DSP_HAVE_AVX2
+
+__attribute__((target("avx2")))
+static void widenAvx2( const float* src, double* dst, unsigned int n )
+{
+  unsigned int i = 0;
+  for( ; i + 8 <= n; i += 8 )
+  {
+    _mm256_storeu_pd(dst + i, _mm256_cvtps_pd(_mm_loadu_ps(src + i)));
+    _mm256_storeu_pd(dst + i + 4, _mm256_cvtps_pd(_mm_loadu_ps(src + i + 4)));
+  }
+  widenScalar(src + i, dst + i, n - i);
+}
+
+__attribute__((target("avx2")))
+static void monoRmsAvx2( const float* left, const float* right, double* dst, unsigned int n )
+{
+  const __m256d one = _mm256_set1_pd(1.0);
+  const __m256d half = _mm256_set1_pd(0.5);
+  unsigned int i = 0;
+  for( ; i + 4 <= n; i += 4 )
+  {
+    __m256d l = _mm256_add_pd(_mm256_cvtps_pd(_mm_loadu_ps(left + i)), one);
+    __m256d r = _mm256_add_pd(_mm256_cvtps_pd(_mm_loadu_ps(right + i)), one);
+    // no FMA here, it would round differently from the scalar code
+    __m256d sum = _mm256_add_pd(_mm256_mul_pd(l, l), _mm256_mul_pd(r, r));
+    _mm256_storeu_pd(dst + i, _mm256_sub_pd(_mm256_sqrt_pd(_mm256_mul_pd(sum, half)), one));
+  }
+  monoRmsScalar(left + i, right + i, dst + i, n - i);
+}
+
+__attribute__((target("avx2")))
+static void butterflyAvx2( double* a_re, double* a_im, double* b_re, double* b_im,
+                           const double* w_re, const double* w_im, unsigned int n )
+{
+  unsigned int j = 0;
+  for( ; j + 4 <= n; j += 4 )
+  {
+    __m256d br = _mm256_loadu_pd(b_re + j);
+    __m256d bi = _mm256_loadu_pd(b_im + j);
+    __m256d wr = _mm256_loadu_pd(w_re + j);
+    __m256d wi = _mm256_loadu_pd(w_im + j);
+    __m256d ar = _mm256_loadu_pd(a_re + j);
+    __m256d ai = _mm256_loadu_pd(a_im + j);
+    // again no FMA, to round like the scalar code
+    __m256d tr = _mm256_sub_pd(_mm256_mul_pd(br, wr), _mm256_mul_pd(bi, wi));
+    __m256d ti = _mm256_add_pd(_mm256_mul_pd(br, wi), _mm256_mul_pd(bi, wr));
+    _mm256_storeu_pd(b_re + j, _mm256_sub_pd(ar, tr));
+    _mm256_storeu_pd(b_im + j, _mm256_sub_pd(ai, ti));
+    _mm256_storeu_pd(a_re + j, _mm256_add_pd(ar, tr));
+    _mm256_storeu_pd(a_im + j, _mm256_add_pd(ai, ti));
+  }
+  butterflyScalar(a_re + j, a_im + j, b_re + j, b_im + j, w_re + j, w_im + j, n - j);
+}
+
+#endif
+
+#ifdef DSP_HAVE_NEON64
+
+static void widenNeon( const float* src, double* dst, unsigned int n )
+{
+  unsigned int i = 0;
+  for( ; i + 4 <= n; i += 4 )
+  {
+    float32x4_t f = vld1q_f32(src + i);
+    vst1q_f64(dst + i, vcvt_f64_f32(vget_low_f32(f)));
+    vst1q_f64(dst + i + 2, vcvt_high_f64_f32(f));
+  }
+  widenScalar(src + i, dst + i, n - i);
+}
+
+static void monoRmsNeon( const float* left, const float* right, double* dst, unsigned int n )
+{
+  const float64x2_t one = vdupq_n_f64(1.0);
+  const float64x2_t half = vdupq_n_f64(0.5);
+  unsigned int i = 0;
+  for( ; i + 2 <= n; i += 2 )
+  {
+    float64x2_t l = vaddq_f64(vcvt_f64_f32(vld1_f32(left + i)), one);
+    float64x2_t r = vaddq_f64(vcvt_f64_f32(vld1_f32(right + i)), one);
+    float64x2_t sum = vaddq_f64(vmulq_f64(l, l), vmulq_f64(r, r));
+    vst1q_f64(dst + i, vsubq_f64(vsqrtq_f64(vmulq_f64(sum, half)), one));
+  }
+  monoRmsScalar(left + i, right + i, dst + i, n - i);
+}
+
+static void butterflyNeon( double* a_re, double* a_im, double* b_re, double* b_im,
+                           const double* w_re, const double* w_im, unsigned int n )
+{
+  unsigned int j = 0;
+  for( ; j + 2 <= n; j += 2 )
+  {
+    float64x2_t br = vld1q_f64(b_re + j);
+    float64x2_t bi = vld1q_f64(b_im + j);
+    float64x2_t wr = vld1q_f64(w_re + j);
+    float64x2_t wi = vld1q_f64(w_im + j);
+    float64x2_t ar = vld1q_f64(a_re + j);
+    float64x2_t ai = vld1q_f64(a_im + j);
+    float64x2_t tr = vsubq_f64(vmulq_f64(br, wr), vmulq_f64(bi, wi));
+    float64x2_t ti = vaddq_f64(vmulq_f64(br, wi), vmulq_f64(bi, wr));
+    vst1q_f64(b_re + j, vsubq_f64(ar, tr));
+    vst1q_f64(b_im + j, vsubq_f64(ai, ti));
+    vst1q_f64(a_re + j, vaddq_f64(ar, tr));
+    vst1q_f64(a_im + j, vaddq_f64(ai, ti));
+  }
+  butterflyScalar(a_re + j, a_im + j, b_re + j, b_im + j, w_re + j, w_im + j, n - j);
+}
+
+static void minMaxNeon( const double* src, unsigned int n, double* min_out, double* max_out )
+{
+  if( n < 8 )
+  {
+    minMaxScalar(src, n, min_out, max_out);
+    return;
+  }
+  float64x2_t mn0 = vld1q_f64(src), mn1 = vld1q_f64(src + 2);
+  float64x2_t mx0 = mn0, mx1 = mn1;
+  unsigned int i = 4;
+  for( ; i + 4 <= n; i += 4 )
+  {
+    float64x2_t v0 = vld1q_f64(src + i);
+    float64x2_t v1 = vld1q_f64(src + i + 2);
+    mn0 = vminq_f64(mn0, v0);
+    mn1 = vminq_f64(mn1, v1);
+    mx0 = vmaxq_f64(mx0, v0);
+    mx1 = vmaxq_f64(mx1, v1);
+  }
+  double rmin = vminvq_f64(vminq_f64(mn0, mn1));
+  double rmax = vmaxvq_f64(vmaxq_f64(mx0, mx1));
+  for( ; i < n; ++i )
+  {
+    if( src[i] < rmin ) rmin = src[i];
+    if( src[i] > rmax ) rmax = src[i];
+  }
+  *min_out = rmin;
+  *max_out = rmax;
+}
+
+#endif
+
+#ifdef DSP_HAVE_NEON
+
+static inline float maxAcrossNeon( float32x4_t v )
+{
+#ifdef DSP_HAVE_NEON64
+  return vmaxvq_f32(v);
+#else
+  float32x2_t m = vpmax_f32(vget_low_f32(v), vget_high_f32(v));
+  return vget_lane_f32(vpmax_f32(m, m), 0);
+#endif
+}
+
+static float peakNeon( const float* src, unsigned int n )
+{
+  float32x4_t peak = vdupq_n_f32(0.0f);
+  unsigned int i = 0;
+  for( ; i + 4 <= n; i += 4 )
+  {
+    peak = vmaxq_f32(peak, vabsq_f32(vld1q_f32(src + i)));
+  }
+  float result = maxAcrossNeon(peak);
+  float rest = peakScalar(src + i, n - i);
+  return rest > result ? rest : result;
+}
+
+#endif
+
+// Runs a candidate over awkwardly sized buffers and compares the output
+// bit for bit with the scalar code.
+static bool matchesScalar( const DspKernels& k )
+{
+  const DspKernels& ref = DspKernels::scalar();
+  const unsigned int n = 1031;
+  std::vector<float> left(n), right(n);
+  unsigned int seed = 12345;
+  for( unsigned int i = 0; i < n; ++i )
+  {
+    seed = seed * 1103515245u + 12345u;
+    left[i] = ((seed >> 8) & 0xffff) / 32768.0f - 1.0f;
+    seed = seed * 1103515245u + 12345u;
+    right[i] = ((seed >> 8) & 0xffff) / 21845.0f - 1.5f;
+  }
+
+  std::vector<double> expected(n), actual(n);
+  for( unsigned int len = 0; len < 20; ++len )
+  {
+    unsigned int count = len < 19 ? len : n;
+    ref.widen(left.data(), expected.data(), count);
+    k.widen(left.data(), actual.data(), count);
+    if( memcmp(expected.data(), actual.data(), count * sizeof(double)) != 0 ) return false;
+
+    ref.monoRms(left.data(), right.data(), expected.data(), count);
+    k.monoRms(left.data(), right.data(), actual.data(), count);
+    if( memcmp(expected.data(), actual.data(), count * sizeof(double)) != 0 ) return false;
+
+    if( ref.peak(right.data(), count) != k.peak(right.data(), count) ) return false;
+
+    ref.widen(right.data(), expected.data(), count);
+    double ref_min = 0, ref_max = 0, min = 0, max = 0;
+    ref.minMax(expected.data(), count, &ref_min, &ref_max);
+    k.minMax(expected.data(), count, &min, &max);
+    if( ref_min != min || ref_max != max ) return false;
+
+    // left/right as a, the widened samples as b and twiddles
+    std::vector<double> ar(count), ai(count), br(count), bi(count), wr(count), wi(count);
+    for( unsigned int i = 0; i < count; ++i )
+    {
+      ar[i] = left[i]; ai[i] = right[i];
+      br[i] = right[n - 1 - i]; bi[i] = left[n - 1 - i];
+      wr[i] = left[(i * 7) % n]; wi[i] = right[(i * 13) % n];
+    }
+    std::vector<double> ar2(ar), ai2(ai), br2(br), bi2(bi);
+    ref.butterfly(ar.data(), ai.data(), br.data(), bi.data(), wr.data(), wi.data(), count);
+    k.butterfly(ar2.data(), ai2.data(), br2.data(), bi2.data(), wr.data(), wi.data(), count);
+    if( ar != ar2 || ai != ai2 || br != br2 || bi != bi2 ) return false;
+  }
+
+  // 32 bit NEON flushes denormals to zero, which would show up here
+  float tiny[8];
+  for( int i = 0; i < 8; ++i )
+  {
+    tiny[i] = (i & 1 ? -1e-40f : 1e-41f) * (i + 1);
+  }
+  return ref.peak(tiny, 8) == k.peak(tiny, 8);
+}
+
+bool DspKernels::matchesScalar() const
+{
+  return ::matchesScalar(*this);
+}
+
+std::vector<DspKernels> DspKernels::candidates()
+{
+  std::vector<DspKernels> candidates;
+#ifdef DSP_HAVE_AVX2
+  __builtin_cpu_init();
+  if( __builtin_cpu_supports("avx2") )
+  {
+    candidates.push_back(DspKernels{ "AVX2", widenAvx2, monoRmsAvx2, peakSse2, minMaxSse2, butterflyAvx2 });
+  }
+#endif
+#ifdef DSP_HAVE_SSE2
+  candidates.push_back(DspKernels{ "SSE2", widenSse2, monoRmsSse2, peakSse2, minMaxSse2, butterflySse2 });
+#endif
+#if defined(DSP_HAVE_NEON64)
+  candidates.push_back(DspKernels{ "NEON", widenNeon, monoRmsNeon, peakNeon, minMaxNeon, butterflyNeon });
+#elif defined(DSP_HAVE_NEON)
+  candidates.push_back(DspKernels{ "NEON", widenScalar, monoRmsScalar, peakNeon, minMaxScalar, butterflyScalar });
+#endif
+  return candidates;
+}
+
+static DspKernels selectKernels()
+{
+  for( const DspKernels& k : DspKernels::candidates() )
+  {
+    if( matchesScalar(k) )
+    {
+      std::cout << "[GUI] - scope DSP kernels: " << k.name << std::endl;
+      return k;
+    }
+    std::cout << "[GUI] - scope DSP kernels: " << k.name << " failed self check, skipping" << std::endl;
+  }
+  std::cout << "[GUI] - scope DSP kernels: scalar" << std::endl;
+  return DspKernels::scalar();
+}
+
+const DspKernels& DspKernels::scalar()
+{
+  static const DspKernels k = { "scalar", widenScalar, monoRmsScalar, peakScalar, minMaxScalar, butterflyScalar };
+  return k;
+}
+
+const DspKernels& DspKernels::get()
+{
+  static const DspKernels k = selectKernels();
+  return k;
+}
@@ -0,0 +1,50 @@
+//--
+// This file is part of Sonic Pi: http://sonic-pi.net
+// Full project source: https://github.com/samaaron/sonic-pi
+// License: https://github.com/samaaron/sonic-pi/blob/master/LICENSE.md
+//
+// Copyright 2013, 2014, 2015, 2016 by Sam Aaron (http://sam.aaron.name).
+// All rights reserved.
+//
+// Permission is granted for use, copying, modification, and
+// distribution of modified versions of this work as long as this
+// notice is included.
+//++
+
+#ifndef DSPKERNELS_H
+#define DSPKERNELS_H
+
+#include <vector>
+
+// Sample conversion, reduction and FFT loops used by the visualizer.
+// The best implementation for the running CPU (AVX2, SSE2, NEON or
+// plain C++; 32 bit NEON only covers peak, having no double lanes) is picked on
+// first use and checked against the scalar code before it is trusted;
+// every implementation gives identical results.
+struct DspKernels
+{
+  const char* name;
+
+  // dst[i] = src[i]
+  void (*widen)( const float* src, double* dst, unsigned int n );
+  // dst[i] = sqrt(((l[i] + 1)^2 + (r[i] + 1)^2) / 2) - 1
+  void (*monoRms)( const float* left, const float* right, double* dst, unsigned int n );
+  // largest absolute sample, 0 when n is 0
+  float (*peak)( const float* src, unsigned int n );
+  // smallest and largest sample, untouched when n is 0
+  void (*minMax)( const double* src, unsigned int n, double* min_out, double* max_out );
+  // radix-2 FFT butterflies with contiguous twiddles w:
+  // t = b[j] * w[j], b[j] = a[j] - t, a[j] = a[j] + t
+  void (*butterfly)( double* a_re, double* a_im, double* b_re, double* b_im,
+                     const double* w_re, const double* w_im, unsigned int n );
+
+  static const DspKernels& get();
+  static const DspKernels& scalar();
+
+  // Every vectorised implementation the running CPU supports, fastest
+  // first, whether or not it passes matchesScalar().
+  static std::vector<DspKernels> candidates();
+  bool matchesScalar() const;
+};
+
+#endif
@@ -0,0 +1,120 @@
+//--
+// This file is part of Sonic Pi: http://sonic-pi.net
+// Full project source: https://github.com/samaaron/sonic-pi
+// License: https://github.com/samaaron/sonic-pi/blob/master/LICENSE.md
+//
+// Copyright 2013, 2014, 2015, 2016 by Sam Aaron (http://sam.aaron.name).
+// All rights reserved.
+//
+// Permission is granted for use, copying, modification, and
+// distribution of modified versions of this work as long as this
+// notice is included.
+//++
+
+#include "fft.h"
+#include "dspkernels.h"
+
+#include <cmath>
+
+RealFFT::RealFFT( unsigned int n ) : n(n), m(n / 2), window(n), bit_reverse(n / 2), twiddle_re(n / 2), twiddle_im(n / 2), split_re(n / 2 + 1), split_im(n / 2 + 1), re(n / 2), im(n / 2), dsp(DspKernels::get())
+{
+  const double pi = 3.14159265358979323846;
+
+  for( unsigned int i = 0; i < n; ++i )
+  {
+    window[i] = 0.5 - 0.5 * cos(2.0 * pi * i / n);
+  }
+
+  unsigned int bits = 0;
+  while( (1u << bits) < m ) ++bits;
+  for( unsigned int i = 0; i < m; ++i )
+  {
+    unsigned int r = 0;
+    for( unsigned int b = 0; b < bits; ++b )
+    {
+      if( i & (1u << b) ) r |= 1u << (bits - 1 - b);
+    }
+    bit_reverse[i] = r;
+  }
+
+  // twiddles for the half size complex transform, one run per stage
+  for( unsigned int half = 1; half < m; half <<= 1 )
+  {
+    for( unsigned int j = 0; j < half; ++j )
+    {
+      twiddle_re[half - 1 + j] = cos(pi * j / half);
+      twiddle_im[half - 1 + j] = -sin(pi * j / half);
+    }
+  }
+
+  // twiddles for splitting the packed result into the real spectrum
+  for( unsigned int k = 0; k <= m; ++k )
+  {
+    split_re[k] = cos(2.0 * pi * k / n);
+    split_im[k] = -sin(2.0 * pi * k / n);
+  }
+
+  // a Hann windowed full scale sine has a peak magnitude of n/4
+  scale = 16.0 / ((double)n * n);
+}
+
+void RealFFT::transform()
+{
+  // Butterflies work on separate real and imaginary arrays with unit
+  // stride loads throughout. The first stages are too short to be worth
+  // a call into the SIMD kernels.
+  for( unsigned int len = 2; len <= m; len <<= 1 )
+  {
+    unsigned int half = len >> 1;
+    const double* w_re = &twiddle_re[half - 1];
+    const double* w_im = &twiddle_im[half - 1];
+    for( unsigned int start = 0; start < m; start += len )
+    {
+      double* a_re = &re[start];
+      double* a_im = &im[start];
+      double* b_re = &re[start + half];
+      double* b_im = &im[start + half];
+      if( half >= 4 )
+      {
+        dsp.butterfly(a_re, a_im, b_re, b_im, w_re, w_im, half);
+        continue;
+      }
+      for( unsigned int j = 0; j < half; ++j )
+      {
+        double t_re = b_re[j] * w_re[j] - b_im[j] * w_im[j];
+        double t_im = b_re[j] * w_im[j] + b_im[j] * w_re[j];
+        b_re[j] = a_re[j] - t_re;
+        b_im[j] = a_im[j] - t_im;
+        a_re[j] += t_re;
+        a_im[j] += t_im;
+      }
+    }
+  }
+}
+
+void RealFFT::powerSpectrum( const double* input, double* power )
+{
+  // pack even samples as real and odd samples as imaginary parts
+  for( unsigned int i = 0; i < m; ++i )
+  {
+    unsigned int r = bit_reverse[i];
+    re[r] = input[2 * i] * window[2 * i];
+    im[r] = input[2 * i + 1] * window[2 * i + 1];
+  }
+
+  transform();
+
+  for( unsigned int k = 0; k <= m; ++k )
+  {
+    unsigned int a = k % m;
+    unsigned int b = (m - k) % m;
+    // even and odd sample spectra
+    double e_re = 0.5 * (re[a] + re[b]);
+    double e_im = 0.5 * (im[a] - im[b]);
+    double o_re = 0.5 * (im[a] + im[b]);
+    double o_im = -0.5 * (re[a] - re[b]);
+    double x_re = e_re + split_re[k] * o_re - split_im[k] * o_im;
+    double x_im = e_im + split_re[k] * o_im + split_im[k] * o_re;
+    power[k] = (x_re * x_re + x_im * x_im) * scale;
+  }
+}
@@ -0,0 +1,55 @@
+//--
+// This file is part of Sonic Pi: http://sonic-pi.net
+// Full project source: https://github.com/samaaron/sonic-pi
+// License: https://github.com/samaaron/sonic-pi/blob/master/LICENSE.md
+//
+// Copyright 2013, 2014, 2015, 2016 by Sam Aaron (http://sam.aaron.name).
+// All rights reserved.
+//
+// Permission is granted for use, copying, modification, and
+// distribution of modified versions of this work as long as this
+// notice is included.
+//++
+
+#ifndef FFT_H
+#define FFT_H
+
+#include <vector>
+
+struct DspKernels;
+
+// Power spectrum of a block of real samples. A real block of n samples
+// is packed into a complex block of n/2, transformed with an iterative
+// radix-2 FFT and then split back into the real spectrum. The window,
+// bit reversal order and all twiddle factors are computed up front, so
+// a transform only does arithmetic. Each stage keeps its own contiguous
+// twiddles so the butterflies can run on the DspKernels SIMD code.
+class RealFFT
+{
+public:
+  // n must be a power of two, at least 4
+  explicit RealFFT( unsigned int n );
+
+  unsigned int size() const { return n; }
+  unsigned int bins() const { return n / 2 + 1; }
+
+  // Hann windows input and writes |X[k]|^2 for k in [0, n/2] to
+  // power, scaled so a full scale sine peaks at 1.
+  void powerSpectrum( const double* input, double* power );
+
+private:
+  void transform();
+
+  unsigned int n;
+  unsigned int m;
+  std::vector<double> window;
+  std::vector<unsigned int> bit_reverse;
+  // the twiddles of the stage with half length h start at h - 1
+  std::vector<double> twiddle_re, twiddle_im;
+  std::vector<double> split_re, split_im;
+  std::vector<double> re, im;
+  double scale;
+  const DspKernels& dsp;
+};
+
+#endif
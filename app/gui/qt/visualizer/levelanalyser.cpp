@@ -0,0 +1,113 @@
+//--
+// This file is part of Sonic Pi: http://sonic-pi.net
+// Full project source: https://github.com/samaaron/sonic-pi
+// License: https://github.com/samaaron/sonic-pi/blob/master/LICENSE.md
+//
+// Copyright 2013, 2014, 2015, 2016 by Sam Aaron (http://sam.aaron.name).
+// All rights reserved.
+//
+// Permission is granted for use, copying, modification, and
+// distribution of modified versions of this work as long as this
+// notice is included.
+//++
+
+#include "levelanalyser.h"
+
+#include "dspkernels.h"
+#include <cmath>
+#include <algorithm>
+
+LevelAnalyser::LevelAnalyser( double sample_rate, double rms_window_secs ) : rms_window_secs(rms_window_secs), squares(std::max(1u, (unsigned int)(sample_rate * rms_window_secs)), 0.0f), square_pos(0), square_sum(0), history_pos(0), restarting(false), block_peak(0), block_true_peak(0), clips(0), clipping(false)
+{
+  std::fill(history, history + 2 * TAPS, 0.0f);
+
+  // Hann windowed sinc interpolators for the fractional positions
+  // 1/4, 2/4 and 3/4 between the two middle samples of the window.
+  const double pi = 3.14159265358979323846;
+  for( int p = 0; p < OVERSAMPLE - 1; ++p )
+  {
+    double frac = (p + 1) / (double)OVERSAMPLE;
+    double sum = 0;
+    for( int t = 0; t < TAPS; ++t )
+    {
+      double x = t - (TAPS / 2 - 1) - frac;
+      double sinc = x == 0 ? 1.0 : sin(pi * x) / (pi * x);
+      double window = 0.5 + 0.5 * cos(pi * x / (TAPS / 2));
+      phases[p][t] = (float)(sinc * window);
+      sum += sinc * window;
+    }
+    for( int t = 0; t < TAPS; ++t )
+    {
+      phases[p][t] /= (float)sum;
+    }
+  }
+}
+
+void LevelAnalyser::setSampleRate( double sample_rate )
+{
+  squares.assign(std::max(1u, (unsigned int)(sample_rate * rms_window_secs)), 0.0f);
+  square_pos = 0;
+  square_sum = 0;
+}
+
+void LevelAnalyser::process( const float* samples, unsigned int n )
+{
+  block_peak = std::max(block_peak, DspKernels::get().peak(samples, n));
+
+  if( restarting && n > 0 )
+  {
+    // hold the first sample rather than zeros, a step from silence
+    // would make the interpolator overshoot
+    std::fill(history, history + 2 * TAPS, samples[0]);
+    restarting = false;
+  }
+
+  unsigned int window = (unsigned int)squares.size();
+  for( unsigned int i = 0; i < n; ++i )
+  {
+    float s = samples[i];
+
+    float sq = s * s;
+    square_sum += sq - squares[square_pos];
+    squares[square_pos] = sq;
+    if( ++square_pos == window )
+    {
+      // resum once per window so rounding errors can't build up
+      square_pos = 0;
+      square_sum = 0;
+      for( float v : squares ) square_sum += v;
+    }
+
+    bool over = std::fabs(s) >= 1.0f;
+    if( over && !clipping ) ++clips;
+    clipping = over;
+
+    history[history_pos] = s;
+    history[history_pos + TAPS] = s;
+    history_pos = (history_pos + 1) % TAPS;
+    const float* h = history + history_pos;
+    float tp = std::fabs(h[TAPS / 2 - 1]);
+    for( int p = 0; p < OVERSAMPLE - 1; ++p )
+    {
+      float acc = 0;
+      for( int t = 0; t < TAPS; ++t )
+      {
+        acc += h[t] * phases[p][t];
+      }
+      tp = std::max(tp, std::fabs(acc));
+    }
+    block_true_peak = std::max(block_true_peak, tp);
+  }
+}
+
+ChannelLevels LevelAnalyser::takeLevels()
+{
+  ChannelLevels levels;
+  levels.peak = block_peak;
+  levels.true_peak = std::max(block_true_peak, block_peak);
+  levels.rms = (float)std::sqrt(std::max(0.0, square_sum) / squares.size());
+  levels.clips = clips;
+  block_peak = 0;
+  block_true_peak = 0;
+  return levels;
+}
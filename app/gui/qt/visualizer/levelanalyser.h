@@ -0,0 +1,75 @@
+//--
+// This file is part of Sonic Pi: http://sonic-pi.net
+// Full project source: https://github.com/samaaron/sonic-pi
+// License: https://github.com/samaaron/sonic-pi/blob/master/LICENSE.md
+//
+// Copyright 2013, 2014, 2015, 2016 by Sam Aaron (http://sam.aaron.name).
+// All rights reserved.
+//
+// Permission is granted for use, copying, modification, and
+// distribution of modified versions of this work as long as this
+// notice is included.
+//++
+
+#ifndef LEVELANALYSER_H
+#define LEVELANALYSER_H
+
+#include <vector>
+
+// Levels of one channel of the master mix over the latest block.
+struct ChannelLevels
+{
+  float peak;        // largest absolute sample
+  float true_peak;   // estimate of the peak between samples
+  float rms;         // over the last rms window
+  unsigned int clips;   // samples at or over full scale so far
+};
+
+// Two channel meter readings published by the scope thread.
+struct LevelReading
+{
+  ChannelLevels channel[2];
+  unsigned long sequence;
+};
+
+// Tracks the levels of one channel incrementally. Each new sample
+// costs a fixed amount of work: a running sum for the RMS window and a
+// short polyphase filter for the 4x oversampled true peak estimate.
+class LevelAnalyser
+{
+public:
+  explicit LevelAnalyser( double sample_rate = 44100.0, double rms_window_secs = 0.3 );
+
+  void process( const float* samples, unsigned int n );
+
+  // resizes the RMS window, which starts again from silence
+  void setSampleRate( double sample_rate );
+  // the next block doesn't follow on from the last one (blocks were
+  // skipped), so the true peak filter mustn't read across the gap
+  void restart() { restarting = true; }
+
+  // levels since the last call, then starts a new block
+  ChannelLevels takeLevels();
+  void resetClips() { clips = 0; }
+
+private:
+  enum { OVERSAMPLE = 4, TAPS = 12 };
+
+  double rms_window_secs;
+  std::vector<float> squares;
+  unsigned int square_pos;
+  double square_sum;
+
+  // the last TAPS samples, stored twice so a window is always contiguous
+  float history[2 * TAPS];
+  unsigned int history_pos;
+  bool restarting;
+  float phases[OVERSAMPLE - 1][TAPS];
+
+  float block_peak;
+  float block_true_peak;
+  unsigned int clips;
+  bool clipping;
+};
+
+#endif
@@ -0,0 +1,182 @@
+//--
+// This file is part of Sonic Pi: http://sonic-pi.net
+// Full project source: https://github.com/samaaron/sonic-pi
+// License: https://github.com/samaaron/sonic-pi/blob/master/LICENSE.md
+//
+// Copyright 2013, 2014, 2015, 2016 by Sam Aaron (http://sam.aaron.name).
+// All rights reserved.
+//
+// Permission is granted for use, copying, modification, and
+// distribution of modified versions of this work as long as this
+// notice is included.
+//++
+
+#include "levelmeter.h"
+
+#include <QPainter>
+#include <QPaintEvent>
+#include <QMouseEvent>
+#include <algorithm>
+#include <cmath>
+
+static const double METER_FLOOR_DB = -60.0;
+static const double METER_CEIL_DB = 3.0;
+// standard peak programme fall rate
+static const double METER_FALL_DB_PER_SEC = 20.0;
+static const double METER_HOLD_SECS = 1.5;
+
+LevelMeter::LevelMeter( QWidget* parent ) : QWidget(parent), color("deeppink")
+{
+  for( Channel& c : channels )
+  {
+    c.peak_db = c.hold_db = c.rms_db = c.true_peak_db = METER_FLOOR_DB;
+    c.hold_secs = 0;
+    c.clips = 0;
+  }
+  last_tick = std::chrono::steady_clock::now();
+  setToolTip(tr("Master levels: RMS (solid), peak, peak hold and true peak.\nThe box on the right turns red and counts clipped samples.\nClick to reset."));
+  setSizePolicy(QSizePolicy::MinimumExpanding, QSizePolicy::Fixed);
+}
+
+QSize LevelMeter::sizeHint() const
+{
+  return QSize(200, 2 * fontMetrics().height() + 6);
+}
+
+double LevelMeter::toDb( float level )
+{
+  if( level <= 0 ) return METER_FLOOR_DB;
+  return std::max(20.0 * log10(level), METER_FLOOR_DB);
+}
+
+double LevelMeter::dbToX( double db, double width ) const
+{
+  return (db - METER_FLOOR_DB) / (METER_CEIL_DB - METER_FLOOR_DB) * width;
+}
+
+void LevelMeter::setColor( QColor c )
+{
+  color = c;
+  update();
+}
+
+void LevelMeter::setReading( const LevelReading& reading )
+{
+  for( int i = 0; i < 2; ++i )
+  {
+    const ChannelLevels& levels = reading.channel[i];
+    Channel& c = channels[i];
+    c.peak_db = std::max(c.peak_db, toDb(levels.peak));
+    c.rms_db = toDb(levels.rms);
+    double true_peak = toDb(levels.true_peak);
+    if( true_peak >= c.hold_db )
+    {
+      c.hold_db = true_peak;
+      c.hold_secs = METER_HOLD_SECS;
+    }
+    c.true_peak_db = std::max(c.true_peak_db, true_peak);
+    c.clips = levels.clips;
+  }
+  update();
+}
+
+bool LevelMeter::tick()
+{
+  auto now = std::chrono::steady_clock::now();
+  double dt = std::chrono::duration<double>(now - last_tick).count();
+  last_tick = now;
+
+  bool moved = false;
+  double fall = METER_FALL_DB_PER_SEC * dt;
+  for( Channel& c : channels )
+  {
+    if( c.peak_db > c.rms_db )
+    {
+      c.peak_db = std::max(c.peak_db - fall, c.rms_db);
+      moved = true;
+    }
+    if( c.hold_secs > 0 )
+    {
+      c.hold_secs -= dt;
+    } else if( c.hold_db > c.peak_db )
+    {
+      c.hold_db = std::max(c.hold_db - fall, c.peak_db);
+      moved = true;
+    }
+  }
+  if( moved )
+  {
+    update();
+  }
+  return moved;
+}
+
+void LevelMeter::mousePressEvent( QMouseEvent* event )
+{
+  Q_UNUSED(event);
+  for( Channel& c : channels )
+  {
+    c.hold_db = c.peak_db;
+    c.hold_secs = 0;
+    c.true_peak_db = METER_FLOOR_DB;
+    c.clips = 0;
+  }
+  emit clipsReset();
+  update();
+}
+
+void LevelMeter::paintEvent( QPaintEvent* event )
+{
+  Q_UNUSED(event);
+  QPainter p(this);
+  QFontMetrics fm = fontMetrics();
+  int label_w = fm.width("R") + 4;
+  int tp_w = fm.width("-00.0") + 6;
+  int clip_w = fm.width("000") + 6;
+  int row_h = (height() - 6) / 2;
+  double bar_w = width() - label_w - tp_w - clip_w - 4;
+
+  QColor dim = color;
+  dim.setAlpha(90);
+  QColor track = color;
+  track.setAlpha(25);
+  QColor hot("red");
+
+  const char* labels[2] = { "L", "R" };
+  for( int i = 0; i < 2; ++i )
+  {
+    const Channel& c = channels[i];
+    int y = 2 + i * (row_h + 2);
+    QRectF bar(label_w, y, bar_w, row_h);
+
+    p.setPen(color);
+    p.drawText(QRect(0, y, label_w, row_h), Qt::AlignCenter, labels[i]);
+
+    p.fillRect(bar, track);
+    p.fillRect(QRectF(bar.left(), y, dbToX(c.peak_db, bar_w), row_h), dim);
+    p.fillRect(QRectF(bar.left(), y, dbToX(c.rms_db, bar_w), row_h), c.peak_db > 0 ? hot : color);
+
+    double hold_x = bar.left() + dbToX(c.hold_db, bar_w);
+    p.fillRect(QRectF(hold_x - 1, y, 2, row_h), c.hold_db > 0 ? hot : color);
+
+    // full scale mark
+    double zero_x = bar.left() + dbToX(0, bar_w);
+    p.fillRect(QRectF(zero_x, y, 1, row_h), dim);
+
+    QRect tp_rect(bar.right() + 2, y, tp_w, row_h);
+    p.setPen(c.true_peak_db > 0 ? hot : color);
+    p.drawText(tp_rect, Qt::AlignCenter, c.true_peak_db <= METER_FLOOR_DB ? QString("-inf") : QString::number(c.true_peak_db, 'f', 1));
+
+    QRect clip_rect(tp_rect.right() + 2, y, clip_w, row_h);
+    if( c.clips > 0 )
+    {
+      p.fillRect(clip_rect, hot);
+      p.setPen(Qt::white);
+      p.drawText(clip_rect, Qt::AlignCenter, c.clips > 999 ? QString("999") : QString::number(c.clips));
+    } else
+    {
+      p.setPen(dim);
+      p.drawRect(clip_rect.adjusted(0, 0, -1, -1));
+    }
+  }
+}
@@ -0,0 +1,65 @@
+//--
+// This file is part of Sonic Pi: http://sonic-pi.net
+// Full project source: https://github.com/samaaron/sonic-pi
+// License: https://github.com/samaaron/sonic-pi/blob/master/LICENSE.md
+//
+// Copyright 2013, 2014, 2015, 2016 by Sam Aaron (http://sam.aaron.name).
+// All rights reserved.
+//
+// Permission is granted for use, copying, modification, and
+// distribution of modified versions of this work as long as this
+// notice is included.
+//++
+
+#ifndef LEVELMETER_H
+#define LEVELMETER_H
+
+#include <QWidget>
+#include <chrono>
+
+#include "levelanalyser.h"
+
+// Stereo peak/RMS meter for the master mix. Readings come from the
+// scope thread; the falling peak bars, peak holds and clip indicators
+// are animated here. Clicking the meter clears the holds and clips.
+class LevelMeter : public QWidget
+{
+  Q_OBJECT
+public:
+  explicit LevelMeter( QWidget* parent = 0 );
+
+  void setReading( const LevelReading& reading );
+  // advances the ballistics, only repaints if something moved, and
+  // returns whether it did
+  bool tick();
+  void setColor( QColor c );
+
+  QSize sizeHint() const;
+
+signals:
+  void clipsReset();
+
+protected:
+  void paintEvent( QPaintEvent* event );
+  void mousePressEvent( QMouseEvent* event );
+
+private:
+  struct Channel
+  {
+    double peak_db;
+    double hold_db;
+    double hold_secs;
+    double rms_db;
+    double true_peak_db;
+    unsigned int clips;
+  };
+
+  static double toDb( float level );
+  double dbToX( double db, double width ) const;
+
+  Channel channels[2];
+  QColor color;
+  std::chrono::steady_clock::time_point last_tick;
+};
+
+#endif
@@ -12,30 +12,42 @@
 //++
 
 #include "scope.h"
+#include "dspkernels.h"
+#include "levelmeter.h"
 
 #include <QPaintEvent>
 #include <QResizeEvent>
 #include <QVBoxLayout>
 #include <QIcon>
 #include <QTimer>
+#include <QApplication>
+#if QT_VERSION >= 0x050000
+  #include <QScreen>
+#endif
 #include <QPainter>
 #include <QDebug>
 #include <qwt_text_label.h>
 #include <cmath>
+#include <algorithm>
+#include <chrono>
 #include <set>
+#include <iostream>
+#include <exception>
 #if (QT_VERSION >= 0x050400) || !defined(Q_OS_LINUX)
   // enable OpenGL rendering on all platforms except Raspberry Pi
   // which is assumed to be Linux + Qt 4
   #include <qwt_plot_glcanvas.h>
 #endif
 
-ScopeBase::ScopeBase( const QString& name, const QString& title, int scsynthPort, QWidget* parent ) : QWidget(parent), name(name), title(title), scsynthPort(scsynthPort), defaultShowX(true), defaultShowY(true), plot(QwtText(name),this)
+ScopeBase::ScopeBase( const QString& name, const QString& title, int scsynthPort, QWidget* parent ) : QWidget(parent), analysis_ms(0), name(name), title(title), scsynthPort(scsynthPort), defaultShowX(true), defaultShowY(true), backend(QwtBackend), render_ms(0), frames_since_status(0), plot(QwtText(name),this), canvas(this)
 {
   QSizePolicy sp(QSizePolicy::MinimumExpanding,QSizePolicy::Expanding);
   plot.setSizePolicy(sp);
+  canvas.setVisible(false);
 
   QVBoxLayout* layout = new QVBoxLayout();
   layout->addWidget(&plot);
+  layout->addWidget(&canvas);
   layout->setContentsMargins(0,0,0,0);
   layout->setSpacing(0);
   setLayout(layout);
@@ -51,6 +63,7 @@ void ScopeBase::setYRange( float min, float max, bool showLabel )
 {
   plot.setAxisScale( QwtPlot::Axis::yLeft, min, max );
   plot.enableAxis( QwtPlot::Axis::yLeft, showLabel );
+  canvas.setYRange( min, max );
   defaultShowY = showLabel;
 }
 
@@ -58,6 +71,7 @@ void ScopeBase::setXRange( float min, float max, bool showLabel )
 {
   plot.setAxisScale( QwtPlot::Axis::xBottom, min, max );
   plot.enableAxis( QwtPlot::Axis::xBottom, showLabel );
+  canvas.setXRange( min, max );
   defaultShowX = showLabel;
 }
 
@@ -72,16 +86,82 @@ bool ScopeBase::setAxesVisible(bool b)
   {
     plot.setTitle(QwtText(""));
   }
+  canvas.setTitle( b ? title : QString() );
   return b;
 }
 
+int ScopeBase::pixelWidth() const
+{
+  return backend == DirectBackend ? canvas.width() : plot.canvas()->width();
+}
+
+bool ScopeBase::wantsSpectrum() const
+{
+  return false;
+}
+
+void ScopeBase::updateSamples()
+{
+}
+
+void ScopeBase::setBackend( Backend b )
+{
+  backend = b;
+  plot.setVisible( backend == QwtBackend );
+  canvas.setVisible( backend == DirectBackend );
+  frames_since_status = 0;
+#if QWT_VERSION >= 0x060100
+  plot.setFooter(QwtText(""));
+#endif
+  canvas.setStatus(QString());
+}
+
 void ScopeBase::refresh( )
 {
-  if( !plot.isVisible() ) return;
-  plot.replot();
+  if( !isVisible() ) return;
+
+  auto start = std::chrono::steady_clock::now();
+  updateSamples();
+  if( backend == DirectBackend )
+  {
+    canvas.repaint();
+  } else
+  {
+    plot.replot();
+  }
+  double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  render_ms = render_ms * 0.9 + ms * 0.1;
+
+  // relabelling relayouts a Qwt plot, so only do it a few times a second
+  if( ++frames_since_status >= 10 )
+  {
+    frames_since_status = 0;
+    showStatus();
+  }
 }
 
-ScopePanel::ScopePanel( const QString& name, const QString& title, int scsynthPort, double* sample_x, double* sample_y, int num_samples, QWidget* parent ) : ScopeBase(name,title,scsynthPort,parent)
+void ScopeBase::showStatus()
+{
+  QString status = QString("%1 ms").arg(render_ms, 0, 'f', 2);
+  if( analysis_ms > 0 )
+  {
+    status += QString(" (analysis %1 ms)").arg(analysis_ms, 0, 'f', 2);
+  }
+
+  if( backend == DirectBackend )
+  {
+    canvas.setStatus(status);
+  } else
+  {
+#if QWT_VERSION >= 0x060100
+    QwtText label(status);
+    label.setFont(QFont(font().family(), 8));
+    plot.setFooter(label);
+#endif
+  }
+}
+
+ScopePanel::ScopePanel( const QString& name, const QString& title, int scsynthPort, ScopeSeriesData* samples, QWidget* parent ) : ScopeBase(name,title,scsynthPort,parent), samples(samples)
 {
 
 #if defined(Q_OS_WIN)
@@ -95,20 +175,23 @@ ScopePanel::ScopePanel( const QString& name, const QString& title, int scsynthPo
   plot_curve.setPaintAttribute( QwtPlotCurve::PaintAttribute::FilterPoints );
 #endif
 
-  plot_curve.setRawSamples( sample_x, sample_y, num_samples );
-  setXRange( 0, num_samples, false );
+  // the curve takes ownership of the series
+  plot_curve.setData( samples );
+  setXRange( 0, samples->sampleCount(), false );
   setYRange( -1, 1, true );
   setPen(QPen(QColor("deeppink"), 2));
 
   plot_curve.attach(&plot);
+  canvas.addCurve( plot_curve.data() );
 }
 
 void ScopePanel::setPen( QPen pen )
 {
   plot_curve.setPen( pen );
+  canvas.setPen( pen );
 }
 
-MultiScopePanel::MultiScopePanel( const QString& name, const QString& title, int scsynthPort, double* sample_x, double samples_y[][4096], unsigned int num_lines, unsigned int num_samples, QWidget* parent ) : ScopeBase(name,title,scsynthPort,parent)
+MultiScopePanel::MultiScopePanel( const QString& name, const QString& title, int scsynthPort, const ScopeFrames& frames, unsigned int num_lines, unsigned int num_samples, QWidget* parent ) : ScopeBase(name,title,scsynthPort,parent)
 {
   for( unsigned int i = 0; i < num_lines; ++i )
   {
@@ -117,8 +200,10 @@ MultiScopePanel::MultiScopePanel( const QString& name, const QString& title, int
   curve->setPaintAttribute( QwtPlotCurve::PaintAttribute::FilterPoints );
 #endif
 
-    curve->setRawSamples( sample_x, samples_y[i], 4096 );
+    auto data = new ScopeSeriesData( frames, i, num_samples );
+    curve->setData( data );
     curve->attach(&plot);
+    canvas.addCurve( data );
     curves.push_back( std::shared_ptr<QwtPlotCurve>(curve) );
   }
 
@@ -133,25 +218,170 @@ void MultiScopePanel::setPen( QPen pen )
   {
     c.get()->setPen(pen);
   }
+  canvas.setPen( pen );
+}
+
+static const unsigned int SPECTRUM_BANDS = 128;
+static const double SPECTRUM_MIN_FREQ = 20.0;
+static const double SPECTRUM_FLOOR_DB = -90.0;
+
+SpectrumPanel::SpectrumPanel( const QString& name, const QString& title, int scsynthPort, const ScopeFrames& frames, unsigned int fft_size, QWidget* parent ) : ScopeBase(name,title,scsynthPort,parent), frames(frames), last_generation(0), fft_size(fft_size), bins(fft_size / 2 + 1), band_lo(SPECTRUM_BANDS), band_hi(SPECTRUM_BANDS), band_x(SPECTRUM_BANDS), band_db(SPECTRUM_BANDS, SPECTRUM_FLOOR_DB), band_peak(SPECTRUM_BANDS, SPECTRUM_FLOOR_DB), peak_hold(SPECTRUM_BANDS, 0)
+{
+  curve.setRawSamples( band_x.data(), band_db.data(), SPECTRUM_BANDS );
+  curve.setBaseline( SPECTRUM_FLOOR_DB );
+  curve.setBrush( QColor(255, 20, 147, 60) );
+  peak_curve.setRawSamples( band_x.data(), band_peak.data(), SPECTRUM_BANDS );
+  peak_curve.setStyle( QwtPlotCurve::Steps );
+
+  setSampleRate( 44100 );
+  setYRange( SPECTRUM_FLOOR_DB, 0, true );
+  setPen(QPen(QColor("deeppink"), 2));
+
+  curve.attach(&plot);
+  peak_curve.attach(&plot);
+  canvas.addCurve( curve.data(), true );
+  canvas.addCurve( peak_curve.data() );
+}
+
+void SpectrumPanel::setPen( QPen pen )
+{
+  curve.setPen( pen );
+  QColor c = pen.color();
+  curve.setBrush( QColor(c.red(), c.green(), c.blue(), 60) );
+  peak_curve.setPen( QPen(c, 1) );
+  canvas.setPen( pen );
+}
+
+bool SpectrumPanel::wantsSpectrum() const
+{
+  return true;
+}
+
+void SpectrumPanel::setSampleRate( double rate )
+{
+  // bands are evenly spaced in log frequency, with x plotted as log10(Hz)
+  double nyquist = rate / 2.0;
+  double lo = log10(SPECTRUM_MIN_FREQ);
+  double hi = log10(nyquist);
+  double bin_hz = rate / fft_size;
+  for( unsigned int b = 0; b < SPECTRUM_BANDS; ++b )
+  {
+    double f0 = pow(10.0, lo + (hi - lo) * b / SPECTRUM_BANDS);
+    double f1 = pow(10.0, lo + (hi - lo) * (b + 1) / SPECTRUM_BANDS);
+    band_x[b] = lo + (hi - lo) * (b + 0.5) / SPECTRUM_BANDS;
+    band_lo[b] = std::min((unsigned int)(f0 / bin_hz + 0.5), bins - 1);
+    band_hi[b] = std::min(std::max((unsigned int)(f1 / bin_hz + 0.5), band_lo[b]), bins - 1);
+  }
+  setXRange( lo, hi, false );
+}
+
+void SpectrumPanel::updateSamples()
+{
+  // the acquisition thread only fills in the power once asked for it
+  const ScopeFrame& frame = frames.readBuffer();
+  if( frame.power.size() != bins || frame.generation == last_generation ) return;
+  last_generation = frame.generation;
+  analysis_ms = frame.spectrum_ms;
+
+  const std::vector<double>& power = frame.power;
+  for( unsigned int b = 0; b < SPECTRUM_BANDS; ++b )
+  {
+    double p = 0;
+    for( unsigned int k = band_lo[b]; k <= band_hi[b]; ++k )
+    {
+      if( power[k] > p ) p = power[k];
+    }
+    double db = std::max(10.0 * log10(p + 1e-12), SPECTRUM_FLOOR_DB);
+
+    // rise quickly, fall slowly
+    band_db[b] += (db - band_db[b]) * (db > band_db[b] ? 0.6 : 0.15);
+
+    if( band_db[b] >= band_peak[b] )
+    {
+      band_peak[b] = band_db[b];
+      peak_hold[b] = 50;
+    } else if( peak_hold[b] > 0 )
+    {
+      --peak_hold[b];
+    } else
+    {
+      band_peak[b] = std::max(band_peak[b] - 0.5, band_db[b]);
+    }
+  }
 }
 
-Scope::Scope( int scsynthPort, QWidget* parent ) : QWidget(parent), paused( false ), emptyFrames(0), scsynthPort(scsynthPort), scsynthIsBooted (false )
+// scope buffers after the master mix that get their own panels
+static const unsigned int NUM_BUS_SCOPES = 4;
+
+// poll interval once the audio has gone quiet
+static const int SCOPE_IDLE_MS = 100;
+static const int SCOPE_IDLE_AFTER_MS = 1000;
+// about -80dB
+static const float SCOPE_SILENCE = 1e-4f;
+// no new scope data for this long means scsynth has gone away
+static const int SCOPE_STALE_MS = 2000;
+static const int SCOPE_ATTACH_MIN_MS = 250;
+static const int SCOPE_ATTACH_MAX_MS = 8000;
+
+Scope::Scope( int scsynthPort, QWidget* parent ) : QWidget(parent), attachBackoffMs(0), analyserRate(44100), fft(4096), fftInput(4096), fftPower(fft.bins()), fftGeneration(0), spectrumMs(0), levelSequence(0), busSequence(0), spectrumPanel(0), sampleRate(44100), meter(0), levels(LevelReading()), metersWanted( false ), resetClipsRequested( false ), busMonitor(0), busReadings(ControlBusReading()), busesWanted( false ), scopeTimer(0), frameIntervalMs(20), audioIdle( true ), paused( false ), displaying( false ), resetRequested( false ), scsynthPort(scsynthPort), scsynthIsBooted (false ), acquiring( true )
 {
-  std::fill_n(sample[0],4096,0);
-  std::fill_n(sample[1],4096,0);
-  std::fill_n(sample_mono,4096,0);
-  panels.push_back( std::shared_ptr<ScopePanel>(new ScopePanel("Lissajous", "Lissajous", scsynthPort, sample[0]+(4096-1024), sample[1]+(4096-1024), 1024, this ) ) );
-  panels.push_back( std::shared_ptr<ScopePanel>(new ScopePanel("Stereo", "Left", scsynthPort, sample_x,sample[0],4096,this) ) );
-  panels.push_back( std::shared_ptr<ScopePanel>(new ScopePanel("Stereo", "Right", scsynthPort, sample_x,sample[1],4096, this) ) );
-//  panels.push_back( std::shared_ptr<MultiScopePanel>(new MultiScopePanel("Stereo",scsynthPort, sample_x,sample,2,4096,this) ) );
-  panels.push_back( std::shared_ptr<ScopePanel>(new ScopePanel("Mono", "Mono", scsynthPort, sample_x,sample_mono,4096, this) ) );
+  // left, right and mono channels of the master mix, plus the last 1024
+  // frames of left against right for the Lissajous panel
+  ScopeSource* master = new ScopeSource(0, 3, 1024);
+  sources.push_back( std::unique_ptr<ScopeSource>(master) );
+  const ScopeFrames& frames = master->frames;
+
+  panels.push_back( std::shared_ptr<ScopePanel>(new ScopePanel("Lissajous", "Lissajous", scsynthPort, new ScopeSeriesData(frames, -1, 1024), this ) ) );
+  panels.push_back( std::shared_ptr<ScopePanel>(new ScopePanel("Stereo", "Left", scsynthPort, new ScopeSeriesData(frames, 0, 4096), this) ) );
+  panels.push_back( std::shared_ptr<ScopePanel>(new ScopePanel("Stereo", "Right", scsynthPort, new ScopeSeriesData(frames, 1, 4096), this) ) );
+//  panels.push_back( std::shared_ptr<MultiScopePanel>(new MultiScopePanel("Stereo",scsynthPort, frames,2,4096,this) ) );
+  panels.push_back( std::shared_ptr<ScopePanel>(new ScopePanel("Mono", "Mono", scsynthPort, new ScopeSeriesData(frames, 2, 4096), this) ) );
+  spectrumPanel = new SpectrumPanel("Spectrum", "Spectrum", scsynthPort, frames, fft.size(), this);
+  panels.push_back( std::shared_ptr<SpectrumPanel>(spectrumPanel) );
+  for( auto p : panels )
+  {
+    master->panels.push_back( p.get() );
+  }
+
+  for( unsigned int i = 1; i <= NUM_BUS_SCOPES; ++i )
+  {
+    ScopeSource* source = new ScopeSource(i, 2);
+    source->wanted = false;
+    sources.push_back( std::unique_ptr<ScopeSource>(source) );
+    QString name = QString("Bus %1").arg(i);
+    auto panel = std::shared_ptr<MultiScopePanel>(new MultiScopePanel(name, name, scsynthPort, source->frames, 2, 4096, this));
+    source->panels.push_back( panel.get() );
+    panels.push_back( panel );
+  }
+
   panels[0]->setPen(QPen(QColor("deeppink"), 1));
   panels[0]->setXRange( -1, 1, true );
 
-  for( unsigned int i = 0; i < 4096; ++i ) sample_x[i] = i;
-  QTimer *scopeTimer = new QTimer(this);
+  meter = new LevelMeter(this);
+  meter->setVisible(false);
+  connect(meter, SIGNAL(clipsReset()), this, SLOT(resetMeterClips()));
+
+  for( auto& bus : watchedBuses )
+  {
+    bus = -1;
+  }
+  busMonitor = new ControlBusMonitor(this);
+  busMonitor->setVisible(false);
+  connect(busMonitor, SIGNAL(busesChanged()), this, SLOT(updateWatchedBuses()));
+
+  // the GUI thread only picks up finished frames and paints them
+#if QT_VERSION >= 0x050000
+  QScreen* screen = QGuiApplication::primaryScreen();
+  if( screen && screen->refreshRate() > 0 )
+  {
+    frameIntervalMs = std::max(8, (int)(1000.0 / screen->refreshRate() + 0.5));
+  }
+#endif
+
+  scopeTimer = new QTimer(this);
+  scopeTimer->setTimerType(Qt::PreciseTimer);
   connect(scopeTimer, SIGNAL(timeout()), this, SLOT(drawLoop()));
-  scopeTimer->start(20);
+  scopeTimer->start(SCOPE_IDLE_MS);
 
   QVBoxLayout* layout = new QVBoxLayout();
   layout->setSpacing(0);
@@ -160,11 +390,17 @@ Scope::Scope( int scsynthPort, QWidget* parent ) : QWidget(parent), paused( fals
   {
     layout->addWidget(p.get());
   }
+  layout->addWidget(meter);
+  layout->addWidget(busMonitor);
   setLayout(layout);
+
+  acquisition = std::thread(&Scope::acquireLoop, this);
 }
 
 Scope::~Scope()
 {
+  acquiring = false;
+  acquisition.join();
 }
 
 std::vector<QString> Scope::getScopeNames() const
@@ -174,12 +410,24 @@ std::vector<QString> Scope::getScopeNames() const
   {
     names.insert(scope->getName());
   }
+  names.insert("Meters");
+  names.insert("Control Buses");
   return std::vector<QString>(names.begin(),names.end());
 }
 
 bool Scope::enableScope( const QString& name, bool on )
 {
   bool any = false;
+  if( name == "Meters" )
+  {
+    meter->setVisible(on);
+    any = true;
+  }
+  if( name == "Control Buses" )
+  {
+    busMonitor->setVisible(on);
+    any = true;
+  }
   for( auto scope : panels )
   {
     if( scope->getName() == name )
@@ -200,6 +448,14 @@ bool Scope::setScopeAxes(bool on)
   return on;
 }
 
+void Scope::setDirectRendering(bool on)
+{
+  for( auto scope : panels )
+  {
+    scope->setBackend( on ? ScopeBase::DirectBackend : ScopeBase::QwtBackend );
+  }
+}
+
 void Scope::scsynthBooted() {
   scsynthIsBooted = true;
 }
@@ -221,64 +477,310 @@ void Scope::setColor(QColor c) {
   {
     scope->setPen(QPen(c, 2));
   }
+  meter->setColor(c);
+  busMonitor->setColor(c);
+}
+
+void Scope::setSampleRate(double rate)
+{
+  if( rate <= 0 ) return;
+  spectrumPanel->setSampleRate( rate );
+  // the analysers belong to the acquisition thread, which picks it up
+  sampleRate = (int)(rate + 0.5);
 }
 
 void Scope::resetScope()
 {
-  shmClient.reset(new server_shared_memory_client(scsynthPort));
-  shmReader = shmClient->get_scope_buffer_reader(0);
+  // the shared memory client belongs to the acquisition thread
+  resetRequested = true;
 }
 
-void Scope::refresh() {
-  if( !scsynthIsBooted) return;
+void Scope::acquireLoop()
+{
+  while( acquiring )
+  {
+    bool active = scsynthIsBooted && displaying;
+    if( active )
+    {
+      acquire();
+    }
+    // poll at the frame rate while there is sound, otherwise just often
+    // enough to notice it starting again
+    int wait = active && !audioIdle ? frameIntervalMs : SCOPE_IDLE_MS;
+    std::this_thread::sleep_for(std::chrono::milliseconds(wait));
+  }
+}
+
+// One pass over the shared memory, skipping buses nobody is looking at.
+void Scope::acquire()
+{
+  auto now = std::chrono::steady_clock::now();
 
-  if( !shmReader.valid() )
+  if( resetRequested || !shmClient || !sources[0]->reader.valid() )
   {
-    resetScope();
+    // remapping the segment is expensive, so back off while scsynth
+    // isn't answering
+    if( now < nextAttach ) return;
+    attachBackoffMs = attachBackoffMs == 0 ? SCOPE_ATTACH_MIN_MS : std::min(attachBackoffMs * 2, SCOPE_ATTACH_MAX_MS);
+    nextAttach = now + std::chrono::milliseconds(attachBackoffMs);
+    resetRequested = false;
+    lastFresh = now;
+
+    try
+    {
+      shmClient.reset(new server_shared_memory_client(scsynthPort));
+    } catch( std::exception& e )
+    {
+      std::cout << "[GUI] - unable to attach to scope shared memory, retrying in " << attachBackoffMs << "ms: " << e.what() << std::endl;
+      shmClient.reset();
+      return;
+    }
+    for( auto& source : sources )
+    {
+      source->reader = shmClient->get_scope_buffer_reader(source->index);
+      source->last_data = 0;
+    }
   }
 
-  unsigned int frames;
-  if( shmReader.pull( frames ) )
+  for( auto& source : sources )
   {
-    emptyFrames = 0;
-    float* data = shmReader.data();
-    for( unsigned int j = 0; j < 2; ++j )
+    if( source->index == 0 )
     {
-      unsigned int offset = shmReader.max_frames() * j;
-      for( unsigned int i = 0; i < 4096 - frames; ++i )
+      // always read, the meters and the idle detection follow it
+      if( pullSource(*source) )
       {
-        sample[j][i] = sample[j][i+frames];
-        if( j == 0 )
-        {
-          sample_mono[i] = sample_mono[i+frames];
-        }
+        lastFresh = now;
+        attachBackoffMs = 0;
+      } else if( now - lastFresh > std::chrono::milliseconds(SCOPE_STALE_MS) )
+      {
+        // scsynth has stopped writing the master scope, it may have
+        // been restarted with a new segment
+        resetRequested = true;
       }
-
-      for( unsigned int i = 0; i < frames; ++i )
+    } else if( source->wanted )
+    {
+      bool active = source->reader.valid();
+      if( active != source->active )
       {
-        sample[j][4096-frames+i] = data[i+offset];
-        auto d = data[i+offset] + 1.0;
-        if(j == 0)
-        {
-          sample_mono[4096-frames+i] = d*d;
-        } else
-        {
-          sample_mono[4096-frames+i] += d*d;
-          sample_mono[4096-frames+i] /= 2.0f;
-          sample_mono[4096-frames+i] = sqrt(sample_mono[4096-frames+i]) - 1.0;
-        }
+        std::cout << "[GUI] - scope buffer " << source->index << (active ? " attached" : " detached") << std::endl;
+        source->active = active;
       }
+      pullSource(*source);
+    }
+    if( source->wanted )
+    {
+      publishFrame(*source);
+    }
+  }
+
+  if( busesWanted )
+  {
+    readControlBuses();
+  }
+}
+
+// Control bus values are plain floats in the shared memory segment, so
+// they can be sampled on every pass without asking the server.
+void Scope::readControlBuses()
+{
+  const float* buses = shmClient->get_control_busses();
+  ControlBusReading& reading = busReadings.writeBuffer();
+  for( int i = 0; i < ControlBusReading::MAX_BUSES; ++i )
+  {
+    int bus = watchedBuses[i];
+    reading.bus[i] = bus;
+    reading.value[i] = bus >= 0 ? buses[bus] : 0.0f;
+  }
+  reading.sequence = ++busSequence;
+  busReadings.publish();
+}
+
+// Copies the newest block of one scope buffer into its history.
+// Returns false if the buffer had nothing new to read.
+bool Scope::pullSource( ScopeSource& source )
+{
+  unsigned int frames;
+  if( !source.reader.valid() || !source.reader.pull( frames ) )
+  {
+    return false;
+  }
+
+  ScopeHistory& history = source.history;
+  float* data = source.reader.data();
+  float* left = data;
+  // a mono bus is drawn on both channels
+  float* right = source.reader.channels() > 1 ? data + source.reader.max_frames() : data;
+
+  // scope_buffer hands back the last block until scsynth writes a new
+  // one, don't scroll it in twice
+  if( data == source.last_data )
+  {
+    return false;
+  }
+  source.last_data = data;
+
+  const DspKernels& dsp = DspKernels::get();
+  if( source.index == 0 )
+  {
+    if( std::max(dsp.peak(left, frames), dsp.peak(right, frames)) > SCOPE_SILENCE )
+    {
+      lastSound = std::chrono::steady_clock::now();
+    }
+    audioIdle = std::chrono::steady_clock::now() - lastSound > std::chrono::milliseconds(SCOPE_IDLE_AFTER_MS);
+    if( metersWanted )
+    {
+      meterFrames(left, right, frames);
+    }
+  }
+
+  // only the newest frames fit if a pull ever exceeds the history
+  unsigned int start = frames > history.length() ? frames - history.length() : 0;
+  unsigned int count = frames - start;
+  double* sample_l = history.channel(0);
+  double* sample_r = history.channel(1);
+  double* sample_mono = history.channels() > 2 ? history.channel(2) : 0;
+
+  // the write may wrap past the end of the history, so convert it in
+  // at most two contiguous runs
+  unsigned int done = 0;
+  while( done < count )
+  {
+    unsigned int idx = history.writeIndex(done);
+    unsigned int run = std::min(count - done, history.length() - idx);
+    const float* l = left + start + done;
+    const float* r = right + start + done;
+    dsp.widen(l, sample_l + idx, run);
+    dsp.widen(r, sample_r + idx, run);
+    if( sample_mono )
+    {
+      dsp.monoRms(l, r, sample_mono + idx, run);
+    }
+    done += run;
+  }
+  history.advance(count);
+  return true;
+}
+
+// Reduces the history of a source to what its panels draw and publishes
+// it, if there are new frames or the panels have changed since the last
+// time. The GUI thread only has to hand the points to the plots.
+void Scope::publishFrame( ScopeSource& source )
+{
+  const ScopeHistory& history = source.history;
+  int width = source.pixel_width;
+  bool spectrum = source.spectrum_wanted;
+  if( history.generation() == source.published_generation && width == source.published_width && spectrum == source.published_spectrum )
+  {
+    return;
+  }
+  source.published_generation = history.generation();
+  source.published_width = width;
+  source.published_spectrum = spectrum;
+
+  ScopeFrame& frame = source.frames.writeBuffer();
+  frame.generation = history.generation();
+  frame.curves.resize(history.channels());
+  for( unsigned int c = 0; c < history.channels(); ++c )
+  {
+    history.curve(c, history.length(), width, frame.curves[c]);
+  }
+  if( source.xy_samples > 0 )
+  {
+    history.pairs(0, 1, source.xy_samples, frame.xy);
+  }
+
+  if( spectrum )
+  {
+    if( fftGeneration != history.generation() )
+    {
+      auto start = std::chrono::steady_clock::now();
+      history.mixDown(fft.size(), fftInput.data());
+      fft.powerSpectrum(fftInput.data(), fftPower.data());
+      fftGeneration = history.generation();
+      double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+      spectrumMs = spectrumMs * 0.9 + ms * 0.1;
     }
+    frame.power = fftPower;
+    frame.spectrum_ms = spectrumMs;
   } else
   {
-    ++emptyFrames;
-    if( emptyFrames > 10 )
+    frame.power.clear();
+  }
+  source.frames.publish();
+}
+
+// Feeds a new block of the master mix to the level meters. Only called
+// for blocks scsynth hasn't handed out before, so nothing is counted
+// twice.
+void Scope::meterFrames( const float* left, const float* right, unsigned int frames )
+{
+  if( resetClipsRequested.exchange(false) )
+  {
+    analysers[0].resetClips();
+    analysers[1].resetClips();
+  }
+  int rate = sampleRate;
+  if( rate != analyserRate )
+  {
+    analysers[0].setSampleRate(rate);
+    analysers[1].setSampleRate(rate);
+    analyserRate = rate;
+  }
+
+  // There is no block counter in the scope buffer, so a block that
+  // arrives later than its own length plus a poll interval after the
+  // last one means scsynth wrote blocks we never saw (or metering was
+  // off), and the true peak filter must not join across the gap.
+  auto now = std::chrono::steady_clock::now();
+  double block_ms = 1000.0 * frames / rate;
+  if( now - lastMetered > std::chrono::duration<double, std::milli>(block_ms + frameIntervalMs + 4) )
+  {
+    analysers[0].restart();
+    analysers[1].restart();
+  }
+  lastMetered = now;
+
+  analysers[0].process(left, frames);
+  analysers[1].process(right, frames);
+
+  LevelReading& reading = levels.writeBuffer();
+  reading.channel[0] = analysers[0].takeLevels();
+  reading.channel[1] = analysers[1].takeLevels();
+  reading.sequence = ++levelSequence;
+  levels.publish();
+}
+
+void Scope::resetMeterClips()
+{
+  resetClipsRequested = true;
+}
+
+void Scope::updateWatchedBuses()
+{
+  const std::vector<int>& buses = busMonitor->buses();
+  for( unsigned int i = 0; i < ControlBusReading::MAX_BUSES; ++i )
+  {
+    watchedBuses[i] = i < buses.size() ? buses[i] : -1;
+  }
+}
+
+// Picks up the newest published frame of every source. Returns true
+// if any of them changed.
+bool Scope::takeFrames()
+{
+  bool fresh = false;
+  for( auto& source : sources )
+  {
+    if( source->frames.acquire() )
     {
-      resetScope();
-      emptyFrames = 0;
+      fresh = true;
     }
   }
+  return fresh;
+}
 
+void Scope::refresh() {
+  takeFrames();
   for( auto scope : panels )
   {
     scope->refresh();
@@ -287,9 +789,64 @@ void Scope::refresh() {
 
 
 void Scope::drawLoop() {
+  displaying = !paused && isVisible();
+  for( auto& source : sources )
+  {
+    bool wanted = false;
+    bool spectrum = false;
+    int width = 0;
+    for( ScopeBase* panel : source->panels )
+    {
+      if( panel->isVisible() )
+      {
+        wanted = true;
+        spectrum = spectrum || panel->wantsSpectrum();
+        width = std::max(width, panel->pixelWidth());
+      }
+    }
+    source->wanted = wanted;
+    source->spectrum_wanted = spectrum;
+    source->pixel_width = width;
+  }
+
+  metersWanted = meter->isVisible();
+  busesWanted = busMonitor->isVisible() && !busMonitor->buses().empty();
+
   // short circuit if possible
-  if( paused ) return;
-  if( !isVisible() ) return;
+  if( !displaying )
+  {
+    scopeTimer->setInterval(SCOPE_IDLE_MS);
+    return;
+  }
+
+  bool animating = false;
+  if( metersWanted )
+  {
+    if( levels.acquire() )
+    {
+      meter->setReading(levels.readBuffer());
+    }
+    animating = meter->tick();
+  }
 
-  refresh();
+  // drop to a slow poll once the audio has been silent for a while,
+  // unless the meters are still falling
+  int interval = audioIdle && !animating && !busesWanted ? SCOPE_IDLE_MS : frameIntervalMs;
+  if( scopeTimer->interval() != interval )
+  {
+    scopeTimer->setInterval(interval);
+  }
+
+  if( busesWanted && busReadings.acquire() )
+  {
+    busMonitor->addReading(busReadings.readBuffer());
+  }
+
+  if( takeFrames() )
+  {
+    for( auto scope : panels )
+    {
+      scope->refresh();
+    }
+  }
 }
@@ -19,11 +19,21 @@
 #include <qwt_plot_curve.h>
 
 #include <visualizer/server_shm.hpp>
+#include <visualizer/scopehistory.h>
+#include <visualizer/fft.h>
+#include <visualizer/scopecanvas.h>
+#include <visualizer/levelanalyser.h>
+#include <visualizer/controlbusmonitor.h>
 #include <memory>
 #include <string>
+#include <atomic>
+#include <thread>
+#include <chrono>
 
 class QPaintEvent;
 class QResizeEvent;
+class LevelMeter;
+class QTimer;
 
 class ScopeBase : public QWidget
 {
@@ -32,40 +42,65 @@ public:
   ScopeBase( const QString& name, const QString& title, int scsynthPort, QWidget* parent = 0 );
   virtual ~ScopeBase();
 
+  // Qwt draws full plots with axes, Direct paints the curves straight
+  // onto a ScopeCanvas and is much cheaper per frame
+  enum Backend { QwtBackend, DirectBackend };
+
   const QString& getName();
   virtual void setPen( QPen pen ) = 0;
 
+  void setBackend( Backend backend );
   void refresh();
   void setXRange( float min, float max, bool showLabel = true );
   void setYRange( float min, float max, bool showLabel = true );
   bool setAxesVisible( bool on );
 
+  // width in pixels the curves are drawn into, which the acquisition
+  // thread reduces the curves to
+  int pixelWidth() const;
+  // whether the acquisition thread should compute a spectrum for this
+  virtual bool wantsSpectrum() const;
+
+protected:
+  // called before each replot of a visible panel
+  virtual void updateSamples();
+
+  // time spent analysing the latest frame, shown next to the render time
+  double analysis_ms;
+
 private:
+  void showStatus();
+
   QString name,title;
   int scsynthPort;
   bool defaultShowX, defaultShowY;
+  Backend backend;
+  double render_ms;
+  int frames_since_status;
 
 protected:
   QwtPlot plot;
+  ScopeCanvas canvas;
 };
 
 
 class ScopePanel : public ScopeBase
 {
 public:
-  ScopePanel( const QString& name, const QString& title, int scsynthPort, double* sample_x, double* sample_y, int num_samples, QWidget* parent = 0 );
+  ScopePanel( const QString& name, const QString& title, int scsynthPort, ScopeSeriesData* samples, QWidget* parent = 0 );
 
   void setPen( QPen pen );
 
 private:
   QwtPlotCurve plot_curve;
+  ScopeSeriesData* samples;
 };
 
 
 class MultiScopePanel : public ScopeBase
 {
 public:
-  MultiScopePanel( const QString& name, const QString& title, int scsynthPort, double* sample_x, double samples_y[][4096], unsigned int num_lines, unsigned int num_samples, QWidget* parent );
+  MultiScopePanel( const QString& name, const QString& title, int scsynthPort, const ScopeFrames& frames, unsigned int num_lines, unsigned int num_samples, QWidget* parent );
 
   void setPen( QPen pen );
 
@@ -74,6 +109,36 @@ private:
 };
 
 
+// Log frequency spectrum of the mixed down stereo history, with
+// smoothing and peak hold. The power spectrum itself is computed by the
+// acquisition thread, the time that takes is shown under the plot.
+class SpectrumPanel : public ScopeBase
+{
+public:
+  SpectrumPanel( const QString& name, const QString& title, int scsynthPort, const ScopeFrames& frames, unsigned int fft_size, QWidget* parent = 0 );
+
+  void setPen( QPen pen );
+  void setSampleRate( double rate );
+  bool wantsSpectrum() const;
+
+protected:
+  void updateSamples();
+
+private:
+  const ScopeFrames& frames;
+  unsigned long last_generation;
+  unsigned int fft_size;
+  unsigned int bins;
+
+  std::vector<unsigned int> band_lo, band_hi;
+  std::vector<double> band_x, band_db, band_peak;
+  std::vector<int> peak_hold;
+
+  QwtPlotCurve curve;
+  QwtPlotCurve peak_curve;
+};
+
+
 class Scope : public QWidget
 {
   Q_OBJECT
@@ -85,6 +150,7 @@ public:
   std::vector<QString> getScopeNames() const;
   bool enableScope( const QString& name, bool on );
   bool setScopeAxes(bool on);
+  void setDirectRendering(bool on);
   void togglePause();
   void pause();
   void resume();
@@ -92,22 +158,94 @@ public:
   void refresh();
   void scsynthBooted();
   void setColor(QColor c);
+  // scsynth's sample rate, for the spectrum axis and the meters
+  void setSampleRate(double rate);
 
 
 private slots:
   void drawLoop();
+  void resetMeterClips();
+  void updateWatchedBuses();
 
 private:
+  // One scsynth scope buffer. Buffer 0 is the master mix, the others
+  // are only written while a synth sends a ScopeOut to them. The
+  // acquisition thread reads into history and publishes it to frames,
+  // reduced to what the panels draw at their current width, and the
+  // panels draw from that on the GUI thread.
+  struct ScopeSource
+  {
+    ScopeSource( unsigned int index, unsigned int channels, unsigned int xy_samples = 0 ) : index(index), history(channels, 4096), frames(ScopeFrame()), xy_samples(xy_samples), wanted(true), pixel_width(0), spectrum_wanted(false), active(false), last_data(0), published_generation(0), published_width(-1), published_spectrum(false) {}
+    unsigned int index;
+    scope_buffer_reader reader;
+    ScopeHistory history;
+    ScopeFrames frames;
+    unsigned int xy_samples;
+    std::vector<ScopeBase*> panels;
+    // set by the GUI thread from the visible panels
+    std::atomic<bool> wanted;
+    std::atomic<int> pixel_width;
+    std::atomic<bool> spectrum_wanted;
+    bool active;
+    // scope_buffer hands back the same block until scsynth writes a new
+    // one, which then always lives at a different address
+    const float* last_data;
+    // what the last published frame was reduced from
+    unsigned long published_generation;
+    int published_width;
+    bool published_spectrum;
+  };
+
+  void meterFrames( const float* left, const float* right, unsigned int frames );
+  void readControlBuses();
+
+  void acquireLoop();
+  void acquire();
+  bool pullSource( ScopeSource& source );
+  void publishFrame( ScopeSource& source );
+  bool takeFrames();
+
+  // only touched by the acquisition thread
   std::unique_ptr<server_shared_memory_client> shmClient;
-  double sample_x[4096];
-  double sample[2][4096];
-  double sample_mono[4096];
-  scope_buffer_reader shmReader;
+  std::chrono::steady_clock::time_point lastFresh;
+  std::chrono::steady_clock::time_point lastSound;
+  std::chrono::steady_clock::time_point nextAttach;
+  int attachBackoffMs;
+  LevelAnalyser analysers[2];
+  int analyserRate;
+  std::chrono::steady_clock::time_point lastMetered;
+  RealFFT fft;
+  std::vector<double> fftInput;
+  std::vector<double> fftPower;
+  unsigned long fftGeneration;
+  double spectrumMs;
+  unsigned long levelSequence;
+  unsigned long busSequence;
+
+  // master mix, then the monitored buses
+  std::vector<std::unique_ptr<ScopeSource>> sources;
   std::vector<std::shared_ptr<ScopeBase>> panels;
-  bool paused;
-  unsigned int emptyFrames;
+  SpectrumPanel* spectrumPanel;
+  std::atomic<int> sampleRate;
+  LevelMeter* meter;
+  TripleBuffer<LevelReading> levels;
+  std::atomic<bool> metersWanted;
+  std::atomic<bool> resetClipsRequested;
+  ControlBusMonitor* busMonitor;
+  TripleBuffer<ControlBusReading> busReadings;
+  std::atomic<int> watchedBuses[ControlBusReading::MAX_BUSES];
+  std::atomic<bool> busesWanted;
+  QTimer* scopeTimer;
+  // paint interval while audio is flowing, from the screen refresh rate
+  int frameIntervalMs;
+  std::atomic<bool> audioIdle;
+  std::atomic<bool> paused;
+  std::atomic<bool> displaying;
+  std::atomic<bool> resetRequested;
   int scsynthPort;
-  bool scsynthIsBooted;
+  std::atomic<bool> scsynthIsBooted;
+  std::atomic<bool> acquiring;
+  std::thread acquisition;
 };
 
 #endif
@@ -0,0 +1,137 @@
+//--
+// This file is part of Sonic Pi: http://sonic-pi.net
+// Full project source: https://github.com/samaaron/sonic-pi
+// License: https://github.com/samaaron/sonic-pi/blob/master/LICENSE.md
+//
+// Copyright 2013, 2014, 2015, 2016 by Sam Aaron (http://sam.aaron.name).
+// All rights reserved.
+//
+// Permission is granted for use, copying, modification, and
+// distribution of modified versions of this work as long as this
+// notice is included.
+//++
+
+#include "scopecanvas.h"
+
+#include <QPainter>
+#include <QPaintEvent>
+#include <QResizeEvent>
+
+ScopeCanvas::ScopeCanvas( QWidget* parent ) : QWidget(parent), pen(QColor("deeppink"), 2), x_min(0), x_max(1), y_min(-1), y_max(1), background_dirty(true)
+{
+  setAttribute(Qt::WA_OpaquePaintEvent);
+  setSizePolicy(QSizePolicy(QSizePolicy::MinimumExpanding, QSizePolicy::Expanding));
+}
+
+void ScopeCanvas::addCurve( const QwtSeriesData<QPointF>* data, bool filled )
+{
+  Curve c = { data, filled };
+  curves.push_back(c);
+}
+
+void ScopeCanvas::setPen( QPen p )
+{
+  pen = p;
+  background_dirty = true;
+  update();
+}
+
+void ScopeCanvas::setXRange( double min, double max )
+{
+  x_min = min;
+  x_max = max;
+}
+
+void ScopeCanvas::setYRange( double min, double max )
+{
+  y_min = min;
+  y_max = max;
+  background_dirty = true;
+}
+
+void ScopeCanvas::setTitle( const QString& t )
+{
+  title = t;
+  background_dirty = true;
+  update();
+}
+
+void ScopeCanvas::setStatus( const QString& s )
+{
+  status = s;
+}
+
+void ScopeCanvas::resizeEvent( QResizeEvent* event )
+{
+  background_dirty = true;
+  QWidget::resizeEvent(event);
+}
+
+void ScopeCanvas::renderBackground()
+{
+  background = QPixmap(size());
+  background.fill(palette().color(backgroundRole()));
+
+  QPainter p(&background);
+  QColor grid = pen.color();
+  grid.setAlpha(60);
+  p.setPen(QPen(grid, 1));
+  p.drawRect(0, 0, width() - 1, height() - 1);
+  if( y_min < 0 && y_max > 0 )
+  {
+    double y = (y_max / (y_max - y_min)) * (height() - 1);
+    p.drawLine(QPointF(0, y), QPointF(width() - 1, y));
+  }
+  if( !title.isEmpty() )
+  {
+    p.setPen(pen.color());
+    p.drawText(rect().adjusted(4, 2, -4, -2), Qt::AlignTop | Qt::AlignHCenter, title);
+  }
+  background_dirty = false;
+}
+
+void ScopeCanvas::paintEvent( QPaintEvent* event )
+{
+  Q_UNUSED(event);
+  if( background_dirty || background.size() != size() )
+  {
+    renderBackground();
+  }
+
+  QPainter p(this);
+  p.drawPixmap(0, 0, background);
+
+  double sx = (width() - 1) / (x_max - x_min);
+  double sy = (height() - 1) / (y_max - y_min);
+  p.setPen(pen);
+  for( const Curve& c : curves )
+  {
+    size_t n = c.data->size();
+    polyline.resize((int)n);
+    for( size_t i = 0; i < n; ++i )
+    {
+      QPointF s = c.data->sample(i);
+      polyline[(int)i] = QPointF((s.x() - x_min) * sx, (y_max - s.y()) * sy);
+    }
+
+    if( c.filled && n > 1 )
+    {
+      QColor fill = pen.color();
+      fill.setAlpha(60);
+      QPolygonF area(polyline);
+      area << QPointF(area.last().x(), height()) << QPointF(area.first().x(), height());
+      p.setPen(Qt::NoPen);
+      p.setBrush(fill);
+      p.drawPolygon(area);
+      p.setBrush(Qt::NoBrush);
+      p.setPen(pen);
+    }
+    p.drawPolyline(polyline);
+  }
+
+  if( !status.isEmpty() )
+  {
+    p.setPen(pen.color());
+    p.drawText(rect().adjusted(4, 2, -4, -2), Qt::AlignBottom | Qt::AlignRight, status);
+  }
+}
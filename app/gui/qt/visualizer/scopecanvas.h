@@ -0,0 +1,64 @@
+//--
+// This file is part of Sonic Pi: http://sonic-pi.net
+// Full project source: https://github.com/samaaron/sonic-pi
+// License: https://github.com/samaaron/sonic-pi/blob/master/LICENSE.md
+//
+// Copyright 2013, 2014, 2015, 2016 by Sam Aaron (http://sam.aaron.name).
+// All rights reserved.
+//
+// Permission is granted for use, copying, modification, and
+// distribution of modified versions of this work as long as this
+// notice is included.
+//++
+
+#ifndef SCOPECANVAS_H
+#define SCOPECANVAS_H
+
+#include <QWidget>
+#include <QPixmap>
+#include <QPen>
+#include <qwt_series_data.h>
+#include <vector>
+
+// Draws scope curves straight onto the widget with QPainter, without
+// QwtPlot's scale and layout work. The frame, zero line and title are
+// rendered into a cached pixmap only when the size, pen or title
+// change; a repaint then just blits that and draws the polylines.
+class ScopeCanvas : public QWidget
+{
+  Q_OBJECT
+public:
+  explicit ScopeCanvas( QWidget* parent = 0 );
+
+  // the series are owned by their QwtPlotCurve, not the canvas
+  void addCurve( const QwtSeriesData<QPointF>* data, bool filled = false );
+  void setPen( QPen pen );
+  void setXRange( double min, double max );
+  void setYRange( double min, double max );
+  void setTitle( const QString& title );
+  void setStatus( const QString& status );
+
+protected:
+  void paintEvent( QPaintEvent* event );
+  void resizeEvent( QResizeEvent* event );
+
+private:
+  struct Curve
+  {
+    const QwtSeriesData<QPointF>* data;
+    bool filled;
+  };
+
+  void renderBackground();
+
+  std::vector<Curve> curves;
+  QPen pen;
+  double x_min, x_max, y_min, y_max;
+  QString title;
+  QString status;
+  QPixmap background;
+  bool background_dirty;
+  QPolygonF polyline;
+};
+
+#endif
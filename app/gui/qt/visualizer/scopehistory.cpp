@@ -0,0 +1,148 @@
+//--
+// This file is part of Sonic Pi: http://sonic-pi.net
+// Full project source: https://github.com/samaaron/sonic-pi
+// License: https://github.com/samaaron/sonic-pi/blob/master/LICENSE.md
+//
+// Copyright 2013, 2014, 2015, 2016 by Sam Aaron (http://sam.aaron.name).
+// All rights reserved.
+//
+// Permission is granted for use, copying, modification, and
+// distribution of modified versions of this work as long as this
+// notice is included.
+//++
+
+#include "scopehistory.h"
+#include "dspkernels.h"
+
+#include <algorithm>
+
+ScopeHistory::ScopeHistory( unsigned int num_channels, unsigned int length ) : data(num_channels, std::vector<double>(length, 0.0)), len(length), mask(length - 1), head(0), gen(0)
+{
+}
+
+void ScopeHistory::advance( unsigned int frames )
+{
+  head = (head + frames) & mask;
+  ++gen;
+}
+
+void ScopeHistory::clear()
+{
+  for( auto& c : data )
+  {
+    std::fill(c.begin(), c.end(), 0.0);
+  }
+  head = 0;
+  ++gen;
+}
+
+void ScopeHistory::curve( unsigned int c, unsigned int num_samples, int pixel_width, std::vector<QPointF>& points ) const
+{
+  num_samples = std::min(num_samples, len);
+  unsigned int offset = len - num_samples;
+
+  // two points per pixel, so only worth reducing above that
+  if( pixel_width <= 0 || num_samples <= 2 * (unsigned int)pixel_width )
+  {
+    points.resize(num_samples);
+    for( unsigned int i = 0; i < num_samples; ++i )
+    {
+      points[i] = QPointF(i, at(c, offset + i));
+    }
+    return;
+  }
+
+  const DspKernels& dsp = DspKernels::get();
+  const double* samples = data[c].data();
+  unsigned int bins = pixel_width;
+  points.resize(bins * 2);
+  for( unsigned int b = 0; b < bins; ++b )
+  {
+    unsigned int first = (unsigned int)((unsigned long)b * num_samples / bins);
+    unsigned int last = (unsigned int)((unsigned long)(b + 1) * num_samples / bins);
+
+    // a pixel covers at most two contiguous runs of the ring
+    unsigned int idx = (head + offset + first) & mask;
+    unsigned int run = std::min(last - first, len - idx);
+    double mn, mx;
+    dsp.minMax(samples + idx, run, &mn, &mx);
+    if( run < last - first )
+    {
+      double mn2, mx2;
+      dsp.minMax(samples, last - first - run, &mn2, &mx2);
+      mn = std::min(mn, mn2);
+      mx = std::max(mx, mx2);
+    }
+
+    // keep the pair in time order so the trace shape is preserved,
+    // within a pixel the exact x doesn't show
+    bool min_first = true;
+    for( unsigned int i = first; i < last; ++i )
+    {
+      double v = at(c, offset + i);
+      if( v == mn || v == mx )
+      {
+        min_first = v == mn;
+        break;
+      }
+    }
+    QPointF lo(min_first ? first : last - 1, mn), hi(min_first ? last - 1 : first, mx);
+    points[2 * b] = min_first ? lo : hi;
+    points[2 * b + 1] = min_first ? hi : lo;
+  }
+}
+
+void ScopeHistory::pairs( unsigned int x, unsigned int y, unsigned int num_samples, std::vector<QPointF>& points ) const
+{
+  num_samples = std::min(num_samples, len);
+  unsigned int offset = len - num_samples;
+  points.resize(num_samples);
+  for( unsigned int i = 0; i < num_samples; ++i )
+  {
+    points[i] = QPointF(at(x, offset + i), at(y, offset + i));
+  }
+}
+
+void ScopeHistory::mixDown( unsigned int n, double* out ) const
+{
+  for( unsigned int i = 0; i < n; ++i )
+  {
+    out[i] = 0.5 * (at(0, i) + at(1, i));
+  }
+}
+
+ScopeSeriesData::ScopeSeriesData( const ScopeFrames& frames, int channel, unsigned int num_samples ) : frames(frames), channel(channel), num_samples(num_samples)
+{
+}
+
+const std::vector<QPointF>& ScopeSeriesData::points() const
+{
+  static const std::vector<QPointF> none;
+  const ScopeFrame& frame = frames.readBuffer();
+  if( channel < 0 )
+  {
+    return frame.xy;
+  }
+  return (unsigned int)channel < frame.curves.size() ? frame.curves[channel] : none;
+}
+
+size_t ScopeSeriesData::size() const
+{
+  return points().size();
+}
+
+QPointF ScopeSeriesData::sample( size_t i ) const
+{
+  return points()[i];
+}
+
+QRectF ScopeSeriesData::boundingRect() const
+{
+  // the panels use fixed axis scales, so there is no need to scan the
+  // samples for their extent
+  if( channel >= 0 )
+  {
+    return QRectF(0.0, -1.0, num_samples, 2.0);
+  }
+  return QRectF(-1.0, -1.0, 2.0, 2.0);
+}
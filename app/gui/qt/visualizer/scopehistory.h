@@ -0,0 +1,113 @@
+//--
+// This file is part of Sonic Pi: http://sonic-pi.net
+// Full project source: https://github.com/samaaron/sonic-pi
+// License: https://github.com/samaaron/sonic-pi/blob/master/LICENSE.md
+//
+// Copyright 2013, 2014, 2015, 2016 by Sam Aaron (http://sam.aaron.name).
+// All rights reserved.
+//
+// Permission is granted for use, copying, modification, and
+// distribution of modified versions of this work as long as this
+// notice is included.
+//++
+
+#ifndef SCOPEHISTORY_H
+#define SCOPEHISTORY_H
+
+#include <qwt_series_data.h>
+#include <vector>
+
+#include "triplebuffer.h"
+
+// Fixed length sample history for the scope panels, owned by the scope
+// acquisition thread. New frames are written at a moving cursor instead
+// of shifting the whole history, so the cost of a refresh scales with
+// the number of new frames.
+class ScopeHistory
+{
+public:
+  // length must be a power of two
+  ScopeHistory( unsigned int num_channels, unsigned int length );
+
+  unsigned int length() const { return len; }
+  unsigned int channels() const { return (unsigned int)data.size(); }
+
+  // Raw storage index for the i'th frame of the next write. Frames are
+  // only visible to readers once advance() has been called.
+  unsigned int writeIndex( unsigned int i ) const { return (head + i) & mask; }
+  double* channel( unsigned int c ) { return data[c].data(); }
+  void advance( unsigned int frames );
+
+  // changes whenever new frames arrive, so readers can cache
+  unsigned long generation() const { return gen; }
+
+  // i'th oldest sample of channel c
+  double at( unsigned int c, unsigned int i ) const { return data[c][(head + i) & mask]; }
+
+  // Points for a time based curve of the newest num_samples samples of
+  // channel c, with x as the sample index. Once there are more than two
+  // samples per pixel they are reduced to the min and max of each of
+  // the pixel_width pixels, so drawing cost follows the widget width
+  // while peaks stay visible.
+  void curve( unsigned int c, unsigned int num_samples, int pixel_width, std::vector<QPointF>& points ) const;
+  // the newest num_samples samples of channel x against channel y
+  void pairs( unsigned int x, unsigned int y, unsigned int num_samples, std::vector<QPointF>& points ) const;
+  // the oldest n samples of the average of channels 0 and 1
+  void mixDown( unsigned int n, double* out ) const;
+
+  void clear();
+
+private:
+  std::vector<std::vector<double>> data;
+  unsigned int len;
+  unsigned int mask;
+  unsigned int head;
+  unsigned long gen;
+};
+
+
+// What the panels of one scope buffer draw, reduced from its history
+// by the acquisition thread and published through a TripleBuffer. The
+// vectors keep their capacity, so publishing doesn't allocate once the
+// sizes have settled.
+struct ScopeFrame
+{
+  ScopeFrame() : generation(0), spectrum_ms(0) {}
+
+  // the history generation this frame was reduced from
+  unsigned long generation;
+  // per channel points of the time based curves
+  std::vector<std::vector<QPointF>> curves;
+  // channel 0 against channel 1, for the Lissajous panel
+  std::vector<QPointF> xy;
+  // power spectrum of the mix, empty unless a spectrum is wanted
+  std::vector<double> power;
+  // time the acquisition thread spends on the spectrum, smoothed
+  double spectrum_ms;
+};
+
+typedef TripleBuffer<ScopeFrame> ScopeFrames;
+
+
+// One curve of the latest ScopeFrame. A channel below 0 selects the xy
+// points instead of a time based curve.
+class ScopeSeriesData : public QwtSeriesData<QPointF>
+{
+public:
+  ScopeSeriesData( const ScopeFrames& frames, int channel, unsigned int num_samples );
+
+  unsigned int sampleCount() const { return num_samples; }
+
+  size_t size() const;
+  QPointF sample( size_t i ) const;
+  QRectF boundingRect() const;
+
+private:
+  const std::vector<QPointF>& points() const;
+
+  const ScopeFrames& frames;
+  int channel;
+  unsigned int num_samples;
+};
+
+#endif
@@ -0,0 +1,57 @@
+//--
+// This file is part of Sonic Pi: http://sonic-pi.net
+// Full project source: https://github.com/samaaron/sonic-pi
+// License: https://github.com/samaaron/sonic-pi/blob/master/LICENSE.md
+//
+// Copyright 2013, 2014, 2015, 2016 by Sam Aaron (http://sam.aaron.name).
+// All rights reserved.
+//
+// Permission is granted for use, copying, modification, and
+// distribution of modified versions of this work as long as this
+// notice is included.
+//++
+
+#ifndef TRIPLEBUFFER_H
+#define TRIPLEBUFFER_H
+
+#include <atomic>
+
+// Lock free hand-off of whole values from one writer thread to one
+// reader thread, the same scheme scope_buffer uses between scsynth and
+// the GUI. The writer fills writeBuffer() and publishes it, the reader
+// picks up the newest published value with acquire() and may use
+// readBuffer() until its next acquire(). Neither side ever waits, and
+// values the reader didn't get to are simply overwritten.
+template <class T>
+class TripleBuffer
+{
+public:
+  explicit TripleBuffer( const T& initial ) : buffers{ initial, initial, initial }, back(0), front(1), middle(2) {}
+
+  T& writeBuffer() { return buffers[back]; }
+
+  void publish()
+  {
+    back = middle.exchange(back | FRESH, std::memory_order_acq_rel) & INDEX;
+  }
+
+  // true if a newer value was published since the last call
+  bool acquire()
+  {
+    if( !(middle.load(std::memory_order_relaxed) & FRESH) ) return false;
+    front = middle.exchange(front, std::memory_order_acq_rel) & INDEX;
+    return true;
+  }
+
+  const T& readBuffer() const { return buffers[front]; }
+
+private:
+  enum { INDEX = 3, FRESH = 4 };
+
+  T buffers[3];
+  int back;
+  int front;
+  std::atomic<int> middle;
+};
+
+#endif
@@ -9,6 +9,8 @@
 #include <QDesktopServices>
 #include <QCheckBox>
 #include <QComboBox>
+#include <QSpinBox>
+#include <QHBoxLayout>
 #include <QUrl>
 #include <iostream>
 #include <QLabel>
@@ -341,11 +343,31 @@ QGroupBox* SettingsWidget::createEditorPrefsTab() {
     log_auto_scroll = new QCheckBox(tr("Auto-scroll log"));
     log_auto_scroll->setToolTip(tr("Toggle log auto scrolling.\nIf enabled the log is scrolled to the bottom after every new message is displayed."));
 
+    cue_flood_rate = new QSpinBox;
+    cue_flood_rate->setRange(0, 1000);
+    cue_flood_rate->setSpecialValueText(tr("No limit"));
+    cue_flood_rate->setToolTip(tr("Maximum number of lines per second shown for each cue path in the cue log.\nCues arriving faster than this are folded into a single summary line\nshowing their rate and last value. Set to 0 to show every cue."));
+    QLabel *cue_flood_rate_label = new QLabel(tr("Cue lines/sec per path"));
+
+    cue_flood_burst = new QSpinBox;
+    cue_flood_burst->setRange(1, 1000);
+    cue_flood_burst->setToolTip(tr("Number of cues a path may send in a quick burst\nbefore its cue log lines are summarised."));
+    QLabel *cue_flood_burst_label = new QLabel(tr("Cue burst"));
+
+    QHBoxLayout *cue_flood_rate_layout = new QHBoxLayout;
+    cue_flood_rate_layout->addWidget(cue_flood_rate_label);
+    cue_flood_rate_layout->addWidget(cue_flood_rate);
+    QHBoxLayout *cue_flood_burst_layout = new QHBoxLayout;
+    cue_flood_burst_layout->addWidget(cue_flood_burst_label);
+    cue_flood_burst_layout->addWidget(cue_flood_burst);
+
     QVBoxLayout *debug_box_layout = new QVBoxLayout;
     debug_box_layout->addWidget(print_output);
     debug_box_layout->addWidget(log_cues);
     debug_box_layout->addWidget(log_auto_scroll);
     debug_box_layout->addWidget(clear_output_on_run);
+    debug_box_layout->addLayout(cue_flood_rate_layout);
+    debug_box_layout->addLayout(cue_flood_burst_layout);
     debug_box->setLayout(debug_box_layout);
 
     gridEditorPrefs->addWidget(editor_display_box, 0, 0);
@@ -380,10 +402,13 @@ QGroupBox* SettingsWidget::createVisualizationPrefsTab() {
     show_scope_axes = new QCheckBox(tr("Show Axes"));
     show_scope_axes->setToolTip(tr("Toggle the visibility of the axes for the audio oscilloscopes"));
     show_scope_axes->setChecked(true);
+    scope_direct_render = new QCheckBox(tr("Fast rendering"));
+    scope_direct_render->setToolTip(tr("Draw the scopes directly instead of as full plots.\nThis uses much less CPU per frame but doesn't show axis scales.\nThe time taken to draw each scope is shown in its corner."));
     scope_box_kinds->setLayout(scope_box_kinds_layout);
     scope_box_kinds->setToolTip(tr("The audio oscilloscope comes in three flavours which may\nbe viewed independently or all together:\n\nLissajous - illustrates the phase relationship between the left and right channels\nMono - shows a combined view of the left and right channels (using RMS)\nStereo - shows two independent scopes for left and right channels"));
     scope_box_layout->addWidget(show_scopes);
     scope_box_layout->addWidget(show_scope_axes);
+    scope_box_layout->addWidget(scope_direct_render);
     scope_box->setLayout(scope_box_layout);
     viz_tab_layout->addWidget(scope_box, 0, 0);
     viz_tab_layout->addWidget(scope_box_kinds, 1, 0);
@@ -537,6 +562,10 @@ void SettingsWidget::toggleLogAutoScroll() {
     emit logAutoScrollChanged();
 }
 
+void SettingsWidget::updateCueFlood() {
+    emit cueFloodChanged();
+}
+
 void SettingsWidget::updateColourTheme() {
     emit themeChanged();
 }
@@ -549,6 +578,10 @@ void SettingsWidget::toggleScopeAxes() {
     emit scopeAxesChanged();
 }
 
+void SettingsWidget::toggleScopeRenderer() {
+    emit scopeRendererChanged();
+}
+
 void SettingsWidget::updateTransparency(int t) {
     emit transparencyChanged(t);
 }
@@ -598,6 +631,8 @@ void SettingsWidget::updateSettings() {
     piSettings->clear_output_on_run = clear_output_on_run->isChecked();
     piSettings->log_cues = log_cues->isChecked();
     piSettings->log_auto_scroll = log_auto_scroll->isChecked();
+    piSettings->cue_flood_rate = cue_flood_rate->value();
+    piSettings->cue_flood_burst = cue_flood_burst->value();
     piSettings->gui_transparency = gui_transparency_slider->value();
     if (lightModeCheck->isChecked())        { piSettings->theme = SonicPiTheme::LightMode; }
     if (darkModeCheck->isChecked())         { piSettings->theme = SonicPiTheme::DarkMode; }
@@ -607,6 +642,7 @@ void SettingsWidget::updateSettings() {
 
     piSettings->show_scopes = show_scopes->isChecked();
     piSettings->show_scope_axes = show_scope_axes->isChecked();
+    piSettings->scope_direct_render = scope_direct_render->isChecked();
 
     piSettings->check_updates = check_updates->isChecked();
 }
@@ -637,6 +673,13 @@ void SettingsWidget::settingsChanged() {
     clear_output_on_run->setChecked(piSettings->clear_output_on_run);
     log_cues->setChecked(piSettings->log_cues);
     log_auto_scroll->setChecked(piSettings->log_auto_scroll);
+    {
+      // don't let the first spin box write the stale value of the second back
+      QSignalBlocker rate_blocker(cue_flood_rate);
+      QSignalBlocker burst_blocker(cue_flood_burst);
+      cue_flood_rate->setValue(piSettings->cue_flood_rate);
+      cue_flood_burst->setValue(piSettings->cue_flood_burst);
+    }
     gui_transparency_slider->setValue(piSettings->gui_transparency); 
     lightModeCheck->setChecked( piSettings->theme == SonicPiTheme::LightMode );        
     darkModeCheck->setChecked( piSettings->theme == SonicPiTheme::DarkMode );         
@@ -646,6 +689,7 @@ void SettingsWidget::settingsChanged() {
 
     show_scopes->setChecked(piSettings->show_scopes);
     show_scope_axes->setChecked(piSettings->show_scope_axes);
+    scope_direct_render->setChecked(piSettings->scope_direct_render);
 
     check_updates->setChecked(piSettings->check_updates);
 }
@@ -680,6 +724,8 @@ void SettingsWidget::connectAll() {
     connect(clear_output_on_run, SIGNAL(clicked()), this, SLOT(updateSettings()));
     connect(log_cues, SIGNAL(clicked()), this, SLOT(updateSettings()));
     connect(log_auto_scroll, SIGNAL(clicked()), this, SLOT(updateSettings()));
+    connect(cue_flood_rate, SIGNAL(valueChanged(int)), this, SLOT(updateSettings()));
+    connect(cue_flood_burst, SIGNAL(valueChanged(int)), this, SLOT(updateSettings()));
     connect(lightModeCheck, SIGNAL(clicked()), this, SLOT(updateSettings()));
     connect(darkModeCheck, SIGNAL(clicked()), this, SLOT(updateSettings()));
     connect(lightProModeCheck, SIGNAL(clicked()), this, SLOT(updateSettings()));
@@ -694,6 +740,8 @@ void SettingsWidget::connectAll() {
     connect(full_screen, SIGNAL(clicked()), this, SLOT(toggleFullScreen()));
     connect(show_tabs, SIGNAL(clicked()), this, SLOT(toggleTabs()));
     connect(log_auto_scroll, SIGNAL(clicked()), this, SLOT(toggleLogAutoScroll()));
+    connect(cue_flood_rate, SIGNAL(valueChanged(int)), this, SLOT(updateCueFlood()));
+    connect(cue_flood_burst, SIGNAL(valueChanged(int)), this, SLOT(updateCueFlood()));
     connect(lightModeCheck, SIGNAL(clicked()), this, SLOT(updateColourTheme()));
     connect(darkModeCheck, SIGNAL(clicked()), this, SLOT(updateColourTheme()));
     connect(lightProModeCheck, SIGNAL(clicked()), this, SLOT(updateColourTheme()));
@@ -702,8 +750,10 @@ void SettingsWidget::connectAll() {
     connect(gui_transparency_slider, SIGNAL(valueChanged(int)), this, SLOT(updateTransparency(int)));
     
     connect(show_scope_axes, SIGNAL(clicked()), this, SLOT(updateSettings()));
+    connect(scope_direct_render, SIGNAL(clicked()), this, SLOT(updateSettings()));
     connect(show_scopes, SIGNAL(clicked()), this, SLOT(updateSettings()));
     connect(show_scope_axes, SIGNAL(clicked()), this, SLOT(toggleScopeAxes()));
+    connect(scope_direct_render, SIGNAL(clicked()), this, SLOT(toggleScopeRenderer()));
     connect(show_scopes, SIGNAL(clicked()), this, SLOT(toggleScope()));
 
     connect(check_updates, SIGNAL(clicked()), this, SLOT(updateSettings()));
@@ -6,6 +6,7 @@
 #include <QWidget>
 
 class QSlider;
+class QSpinBox;
 class QTabWidget;
 class QBoxLayout;
 class QGroupBox;
@@ -45,9 +46,11 @@ private slots:
     void toggleFullScreen();
     void toggleTabs();
     void toggleLogAutoScroll();
+    void updateCueFlood();
     void updateColourTheme();
     void toggleScope();
     void toggleScopeAxes();
+    void toggleScopeRenderer();
     void toggleScope( QWidget* qw );
     void openSonicPiNet();
     void toggleCheckUpdates();
@@ -69,9 +72,11 @@ signals:
     void showFullscreenChanged();
     void showTabsChanged();
     void logAutoScrollChanged();
+    void cueFloodChanged();
     void themeChanged();
     void scopeChanged();
     void scopeAxesChanged();
+    void scopeRendererChanged();
     void scopeChanged(QString name);
     void transparencyChanged(int t);
     void checkUpdatesChanged();
@@ -90,6 +95,8 @@ private:
     QCheckBox *clear_output_on_run;
     QCheckBox *log_cues;
     QCheckBox *log_auto_scroll;
+    QSpinBox *cue_flood_rate;
+    QSpinBox *cue_flood_burst;
     QCheckBox *enable_external_synths_cb;
     QCheckBox *synth_trigger_timing_guarantees_cb;
     QCheckBox *show_line_numbers;
@@ -116,6 +123,7 @@ private:
 
     QSignalMapper *scopeSignalMap;
     QCheckBox *show_scope_axes;
+    QCheckBox *scope_direct_render;
     QCheckBox *show_scopes;
     QVBoxLayout *scope_box_kinds_layout;
 
@@ -16,12 +16,200 @@
 
 // Standard stuff
 #include <vector>
+#include <algorithm>
+#include <iostream>
 #include "model/sonicpitheme.h"
 #include <QScrollBar>
+#include <QTimer>
+#include <QFile>
+#include <QMenu>
+#include <QContextMenuEvent>
+#include <QDesktopServices>
+#include <QUrl>
+#include <QTextBlock>
+#include <QThreadPool>
+#include <QFutureWatcher>
+#include <QtConcurrent/QtConcurrentRun>
 
 SonicPiLog::SonicPiLog(QWidget *parent) : QPlainTextEdit(parent)
 {
   forceScroll = true;
+  formats_theme = 0;
+  flush_pending = false;
+  last_flush_merged = 0;
+  max_flush_merged = 0;
+  max_lines = 1000;
+  spilled_lines = 0;
+  history_pool = new QThreadPool(this);
+  history_pool->setMaxThreadCount(1);
+  history = 0;
+  history_flush_watcher = 0;
+
+  // Lines only ever arrive at the end or are trimmed from the start, so
+  // there is nothing to undo, and keeping every edit around would grow
+  // without bound on a busy log.
+  document()->setUndoRedoEnabled(false);
+
+  // drain staged spans at most once per display frame
+  flushTimer = new QTimer(this);
+  flushTimer->setSingleShot(true);
+  flushTimer->setInterval(16);
+  connect(flushTimer, SIGNAL(timeout()), this, SLOT(flushStaged()));
+}
+
+SonicPiLog::~SonicPiLog()
+{
+  // let queued spills reach the file before it is closed
+  history_pool->waitForDone();
+  delete history;
+}
+
+void SonicPiLog::setMaxLines(int maxLines)
+{
+  max_lines = std::max(1, maxLines);
+  trimToMaxLines();
+}
+
+// The history file, owned by jobs on the history pool so the GUI thread
+// never waits on the disk.
+struct SonicPiLogHistory
+{
+  QString path;
+  QFile file;
+};
+
+// past this the history is moved to <path>.1 and a new file started, so
+// a long session keeps at most twice this on disk per log
+static const qint64 MAX_HISTORY_BYTES = 8 * 1024 * 1024;
+
+static void openHistoryFile(SonicPiLogHistory *history)
+{
+  // the history only covers this session
+  history->file.setFileName(history->path);
+  if(!history->file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+    std::cout << "[GUI] - unable to open log history file " << history->path.toStdString() << std::endl;
+  }
+}
+
+static void appendHistory(SonicPiLogHistory *history, QByteArray lines)
+{
+  if(!history->file.isOpen()) {
+    return;
+  }
+  if(history->file.size() > 0 && history->file.size() + lines.size() > MAX_HISTORY_BYTES) {
+    history->file.close();
+    QFile::remove(history->path + ".1");
+    QFile::rename(history->path, history->path + ".1");
+    openHistoryFile(history);
+    if(!history->file.isOpen()) {
+      return;
+    }
+  }
+  history->file.write(lines);
+}
+
+static void flushHistory(SonicPiLogHistory *history)
+{
+  if(history->file.isOpen()) {
+    history->file.flush();
+  }
+}
+
+void SonicPiLog::setHistoryFile(QString path)
+{
+  if(history) {
+    history_pool->waitForDone();
+    delete history;
+    history = 0;
+  }
+  history_path = path;
+  spilled_lines = 0;
+  if(path.isEmpty()) {
+    return;
+  }
+
+  history = new SonicPiLogHistory;
+  history->path = path;
+  QtConcurrent::run(history_pool, openHistoryFile, history);
+}
+
+void SonicPiLog::spillBlocks(int count)
+{
+  if(!history) {
+    return;
+  }
+  // the document can only be read here, the write happens on the pool
+  QByteArray lines;
+  QTextBlock block = document()->begin();
+  for(int i = 0; i < count && block.isValid(); i++) {
+    lines.append(block.text().toUtf8());
+    lines.append('\n');
+    block = block.next();
+  }
+  QtConcurrent::run(history_pool, appendHistory, history, lines);
+  spilled_lines += count;
+}
+
+void SonicPiLog::trimToMaxLines()
+{
+  // Trim in batches so a busy log isn't relaid out on every frame.
+  int slack = std::max(1, max_lines / 8);
+  int blocks = document()->blockCount();
+  if(blocks <= max_lines + slack) {
+    return;
+  }
+
+  int excess = blocks - max_lines;
+  spillBlocks(excess);
+
+  QTextCursor cursor(document());
+  cursor.movePosition(QTextCursor::Start);
+  cursor.setPosition(document()->findBlockByNumber(excess).position(), QTextCursor::KeepAnchor);
+  cursor.removeSelectedText();
+}
+
+void SonicPiLog::clear()
+{
+  spillBlocks(document()->blockCount());
+  if(history) {
+    QtConcurrent::run(history_pool, flushHistory, history);
+  }
+  last_line_key.clear();
+  QPlainTextEdit::clear();
+}
+
+void SonicPiLog::openHistory()
+{
+  if(!history || history_flush_watcher) {
+    return;
+  }
+
+  // the file itself is handed to the system viewer once the spills
+  // queued so far have been written out
+  history_flush_watcher = new QFutureWatcher<void>(this);
+  connect(history_flush_watcher, SIGNAL(finished()), this, SLOT(historyFlushed()));
+  history_flush_watcher->setFuture(QtConcurrent::run(history_pool, flushHistory, history));
+}
+
+void SonicPiLog::historyFlushed()
+{
+  history_flush_watcher->deleteLater();
+  history_flush_watcher = 0;
+  if(!QDesktopServices::openUrl(QUrl::fromLocalFile(history_path))) {
+    std::cout << "[GUI] - unable to open log history " << history_path.toStdString() << std::endl;
+  }
+}
+
+void SonicPiLog::contextMenuEvent(QContextMenuEvent *event)
+{
+  QMenu *menu = createStandardContextMenu(event->pos());
+  if(history) {
+    menu->addSeparator();
+    QAction *open = menu->addAction(tr("Open log history (%1 earlier lines)").arg(spilled_lines));
+    connect(open, SIGNAL(triggered()), this, SLOT(openHistory()));
+  }
+  menu->exec(event->globalPos());
+  delete menu;
 }
 
 void SonicPiLog::forceScrollDown(bool force)
@@ -58,27 +246,195 @@ void SonicPiLog::setFontFamily(QString font_name)
   setFont(QFont(font_name));
 }
 
-void SonicPiLog::appendPlainText(QString text)
+void SonicPiLog::scrollToBottom()
 {
-  QPlainTextEdit::appendPlainText(text);
   if(forceScroll) {
     QScrollBar *sb = verticalScrollBar();
     sb->setValue(sb->maximum());
   }
 }
 
+void SonicPiLog::appendPlainText(QString text)
+{
+  last_line_key.clear();
+  QPlainTextEdit::appendPlainText(text);
+  trimToMaxLines();
+  scrollToBottom();
+}
+
+void SonicPiLog::stageText(QString text, SpanStyle style, bool newLine, QString replaceKey, int bgAlpha)
+{
+  {
+    std::lock_guard<std::mutex> lock(staged_mutex);
+    staged.emplace_back();
+    StagedSpan &span = staged.back();
+    span.style = style;
+    span.bgAlpha = bgAlpha;
+    span.newLine = newLine;
+    span.replaceKey.swap(replaceKey);
+    span.text.swap(text);
+  }
+  wakeForFlush();
+}
+
+void SonicPiLog::stageMultiMessage(const SonicPiLog::MultiMessage &mm)
+{
+  {
+    std::lock_guard<std::mutex> lock(staged_mutex);
+    staged_multi.push_back(mm);
+    staged.emplace_back();
+    StagedSpan &span = staged.back();
+    span.style = -1;
+    span.bgAlpha = 255;
+    span.newLine = true;
+  }
+  wakeForFlush();
+}
+
+void SonicPiLog::wakeForFlush()
+{
+  // only the first span staged since the last flush wakes the GUI thread
+  if(!flush_pending.exchange(true, std::memory_order_acq_rel)) {
+    QMetaObject::invokeMethod(this, "scheduleFlush", Qt::QueuedConnection);
+  }
+}
+
+void SonicPiLog::scheduleFlush()
+{
+  if(!flushTimer->isActive()) {
+    flushTimer->start();
+  }
+}
+
+void SonicPiLog::flushStaged()
+{
+  flush_pending.store(false, std::memory_order_release);
+  {
+    std::lock_guard<std::mutex> lock(staged_mutex);
+    staged.swap(flushing);
+    staged_multi.swap(flushing_multi);
+  }
+
+  int merged = (int)flushing.size();
+  if(merged == 0) {
+    return;
+  }
+
+  QTextCursor cursor(document());
+  cursor.movePosition(QTextCursor::End);
+  cursor.beginEditBlock();
+  size_t next_multi = 0;
+  for(size_t i = 0; i < flushing.size(); i++) {
+    const StagedSpan &span = flushing[i];
+    if(span.style < 0) {
+      insertMultiMessage(cursor, flushing_multi[next_multi++]);
+      last_line_key.clear();
+      continue;
+    }
+
+    // until a theme is set spans are drawn in the default colours
+    QTextCharFormat tf = span_formats[span.style];
+    if(span.bgAlpha != 255) {
+      QColor bg = tf.background().color();
+      bg.setAlpha(span.bgAlpha);
+      tf.setBackground(bg);
+    }
+    if(span.newLine && !span.replaceKey.isEmpty() && span.replaceKey == last_line_key) {
+      // rolling line, overwrite it rather than adding another
+      cursor.movePosition(QTextCursor::StartOfBlock, QTextCursor::KeepAnchor);
+      cursor.insertText(span.text, tf);
+    } else if(span.newLine) {
+      appendBlock(cursor, span.text, tf);
+      last_line_key = span.replaceKey;
+    } else {
+      cursor.insertText(span.text, tf);
+      last_line_key.clear();
+    }
+  }
+  cursor.endEditBlock();
+  flushing.clear();
+  flushing_multi.clear();
+  trimToMaxLines();
+  scrollToBottom();
+
+  last_flush_merged = merged;
+  max_flush_merged = std::max(max_flush_merged, merged);
+  setToolTip(tr("Last update merged %1 events (max %2)").arg(last_flush_merged).arg(max_flush_merged));
+  emit flushed(merged);
+}
+
+void SonicPiLog::appendBlock(QTextCursor &cursor, const QString &text, const QTextCharFormat &tf)
+{
+  // matches QPlainTextEdit::appendPlainText, which starts a new block
+  // unless the document is still empty
+  if(!document()->isEmpty()) {
+    cursor.insertBlock();
+  }
+  cursor.insertText(text, tf);
+}
 
 void SonicPiLog::handleMultiMessage(SonicPiLog::MultiMessage mm)
 {
-    int msg_count = mm.messages.size();
-    SonicPiTheme *theme = mm.theme;
+  last_line_key.clear();
+  QTextCursor cursor(document());
+  cursor.movePosition(QTextCursor::End);
+  cursor.beginEditBlock();
+  insertMultiMessage(cursor, mm);
+  cursor.endEditBlock();
+  trimToMaxLines();
+  scrollToBottom();
+}
+
+void SonicPiLog::updateTheme(SonicPiTheme *theme)
+{
+  // Looking colours up by name parses them every time, so the formats
+  // for each message type are built once per theme instead.
+  QColor fg = theme->color("LogForeground");
+  QColor bg = theme->color("LogBackground");
+  base_format = QTextCharFormat();
+  base_format.setForeground(fg);
+  base_format.setBackground(bg);
 
+  for(int i = 0; i < LOG_FORMAT_COUNT; i++) {
     QTextCharFormat tf;
-    QString ss;
+    if(i == 0) {
+      tf = base_format;
+    } else {
+      tf.setForeground(theme->color("LogForeground_" + QString::number(i)));
+      tf.setBackground(theme->color("LogBackground_" + QString::number(i)));
+    }
+    msg_formats[i] = tf;
+
+    // joining lines keep the message background
+    tf.setForeground(fg);
+    join_formats[i] = tf;
+  }
+
+  static const char *const SPAN_COLOURS[SPAN_STYLE_COUNT][2] = {
+    { "CuePathBackground", "CuePathForeground" },
+    { "CueDataBackground", "CueDataForeground" },
+    { "LogBackground", 0 },
+    { "LogInfoBackground", "LogInfoForeground" },
+    { "LogInfoBackground_1", "LogInfoForeground_1" },
+  };
+  for(int i = 0; i < SPAN_STYLE_COUNT; i++) {
+    QTextCharFormat tf;
+    tf.setBackground(theme->color(SPAN_COLOURS[i][0]));
+    // the gap between a cue's path and data is always white
+    tf.setForeground(SPAN_COLOURS[i][1] ? theme->color(SPAN_COLOURS[i][1]) : QColor("white"));
+    span_formats[i] = tf;
+  }
+  formats_theme = theme;
+}
 
-    tf.setForeground(theme->color("LogForeground"));
-    tf.setBackground(theme->color("LogBackground"));
-    setCurrentCharFormat(tf);
+void SonicPiLog::insertMultiMessage(QTextCursor &cursor, const SonicPiLog::MultiMessage &mm)
+{
+    if(!formats_theme) {
+      updateTheme(mm.theme);
+    }
+
+    int msg_count = mm.messages.size();
+    QString ss;
 
     ss.append("{run: ").append(QString::number(mm.job_id));
     ss.append(", time: ").append(QString::fromStdString(mm.runtime));
@@ -86,86 +442,36 @@ void SonicPiLog::handleMultiMessage(SonicPiLog::MultiMessage mm)
       ss.append(", thread: ").append(QString::fromStdString(mm.thread_name));
     }
     ss.append("}");
-    appendPlainText(ss);
+    appendBlock(cursor, ss, base_format);
 
     for(int i = 0 ; i < msg_count ; i++) {
-      ss = "";
       int msg_type = mm.messages[i].msg_type;
-      std::string s = mm.messages[i].s;
-
-      QStringList lines = QString::fromUtf8(s.c_str()).split(QRegExp("\\n"));
+      if(msg_type < 0 || msg_type >= LOG_FORMAT_COUNT) {
+        msg_type = 0;
+      }
+      const QTextCharFormat &msg_format = msg_formats[msg_type];
+      const QTextCharFormat &join_format = join_formats[msg_type];
+      const std::string &s = mm.messages[i].s;
+      bool last = (i == (msg_count - 1));
 
       if (s.empty()) {
-          ss.append(QString::fromUtf8(" │"));
-        }
-      else if(i == (msg_count - 1)) {
-        ss.append(QString::fromUtf8(" └─ "));
+        appendBlock(cursor, QString::fromUtf8(" │"), base_format);
+      } else if(last) {
+        appendBlock(cursor, QString::fromUtf8(" └─ "), base_format);
       } else {
-        ss.append(QString::fromUtf8(" ├─ "));
+        appendBlock(cursor, QString::fromUtf8(" ├─ "), base_format);
       }
 
-      appendPlainText(ss);
-
-      for (int j = 0; j < lines.size(); ++j) {
-        switch(msg_type)
-          {
-          case 0:
-             tf.setForeground(theme->color("LogForeground"));
-             tf.setBackground(theme->color("LogBackground"));
-            break;
-          case 1:
-            tf.setForeground(theme->color("LogForeground_1"));
-            tf.setBackground(theme->color("LogBackground_1"));
-            break;
-          case 2:
-            tf.setForeground(theme->color("LogForeground_2"));
-            tf.setBackground(theme->color("LogBackground_2"));
-            break;
-          case 3:
-            tf.setForeground(theme->color("LogForeground_3"));
-            tf.setBackground(theme->color("LogBackground_3"));
-            break;
-          case 4:
-            tf.setForeground(theme->color("LogForeground_4"));
-            tf.setBackground(theme->color("LogBackground_4"));
-            break;
-          case 5:
-            tf.setForeground(theme->color("LogForeground_5"));
-            tf.setBackground(theme->color("LogBackground_5"));
-            break;
-          case 6:
-            tf.setForeground(theme->color("LogForeground_6"));
-            tf.setBackground(theme->color("LogBackground_6"));
-            break;
-          default:
-            tf.setForeground(theme->color("LogForeground"));
-            tf.setBackground(theme->color("LogBackground"));
-
-          }
-
-        setCurrentCharFormat(tf);
-        insertPlainText(lines.at(j));
-        if ((j + 1) < lines.size()) {
-          tf.setForeground(theme->color("LogForeground"));
-          setCurrentCharFormat(tf);
-          if (i == (msg_count - 1)) {
-            // we are the last message
-            // so don't print joining lines
-            insertPlainText("\n  ");
-          } else {
-            insertPlainText("\n │");
-          }
-        }
+      QString text = QString::fromUtf8(s.data(), s.size());
+      int start = 0;
+      int end;
+      while ((end = text.indexOf(QLatin1Char('\n'), start)) != -1) {
+        cursor.insertText(text.mid(start, end - start), msg_format);
+        // the last message doesn't print joining lines
+        cursor.insertText(last ? QStringLiteral("\n  ") : QString::fromUtf8("\n │"), join_format);
+        start = end + 1;
       }
-
-      tf.setForeground(theme->color("LogForeground"));
-      tf.setBackground(theme->color("LogBackground"));
-      setCurrentCharFormat(tf);
-    }
-    appendPlainText(QString::fromStdString(" "));
-
-    if(forceScroll) {
-      QScrollBar *sb = verticalScrollBar();
-      sb->setValue(sb->maximum());
+      cursor.insertText(text.mid(start), msg_format);
     }
+    appendBlock(cursor, QString::fromStdString(" "), base_format);
 }
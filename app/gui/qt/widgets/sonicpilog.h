@@ -15,8 +15,16 @@
 #define SONICPILOG_H
 
 #include <QPlainTextEdit>
+#include <QTextCursor>
+#include <atomic>
+#include <mutex>
+#include <vector>
 
 class SonicPiTheme;
+class QTimer;
+class QThreadPool;
+struct SonicPiLogHistory;
+template <typename T> class QFutureWatcher;
 
 class SonicPiLog : public QPlainTextEdit
 {
@@ -41,7 +49,43 @@ public:
         Messages messages;
     };
 
+    // Theme colours a staged span is drawn in. They are resolved on the
+    // GUI thread when the span is flushed, not by the thread staging it.
+    enum SpanStyle
+    {
+        CuePathSpan,
+        CueDataSpan,
+        CueGapSpan,
+        LogInfoSpan,
+        LogInfoSpan1,
+        SPAN_STYLE_COUNT
+    };
+
+    ~SonicPiLog();
+
+    // Thread safe. Spans are staged in a buffer that is reused from frame
+    // to frame and rendered together on the next display frame by the GUI
+    // thread. A line with a replaceKey overwrites the last line if that
+    // had the same key. bgAlpha applies to the style's background.
+    void stageText(QString text, SpanStyle style, bool newLine = false, QString replaceKey = QString(), int bgAlpha = 255);
+    void stageMultiMessage(const SonicPiLog::MultiMessage &mm);
+
+    // rebuilds the per message type formats, call when the theme changes
+    void updateTheme(SonicPiTheme *theme);
+
+    // Keeps at most maxLines lines in the document. Older lines are
+    // appended to the history file, if one is set, rather than lost. The
+    // file is written off the GUI thread and rotated to <path>.1 once it
+    // reaches a few megabytes.
+    void setMaxLines(int maxLines);
+    void setHistoryFile(QString path);
+    int spilledLines() const { return spilled_lines; }
+
+    int lastFlushMerged() const { return last_flush_merged; }
+    int maxFlushMerged() const { return max_flush_merged; }
+
 signals:
+    void flushed(int merged);
 
 public slots:
     void setTextColor(QColor c);
@@ -51,8 +95,62 @@ public slots:
     void handleMultiMessage(SonicPiLog::MultiMessage mm);
     void forceScrollDown(bool force);
     void appendPlainText(QString text);
+    void clear();
+    void openHistory();
+
+private slots:
+    void scheduleFlush();
+    void flushStaged();
+    void historyFlushed();
+
+private:
+    struct StagedSpan
+    {
+        int style;  // a SpanStyle, or -1 for the next staged multi message
+        int bgAlpha;
+        bool newLine;
+        QString replaceKey;
+        QString text;
+    };
+
+    void wakeForFlush();
+    void appendBlock(QTextCursor &cursor, const QString &text, const QTextCharFormat &tf);
+    void insertMultiMessage(QTextCursor &cursor, const SonicPiLog::MultiMessage &mm);
+    void scrollToBottom();
+    void trimToMaxLines();
+    void spillBlocks(int count);
+
+    // Written by any thread under staged_mutex. flushStaged swaps them
+    // with the flushing buffers, which keep their capacity once cleared.
+    std::mutex staged_mutex;
+    std::vector<StagedSpan> staged;
+    std::vector<MultiMessage> staged_multi;
+    std::vector<StagedSpan> flushing;
+    std::vector<MultiMessage> flushing_multi;
+    std::atomic<bool> flush_pending;
+    QTimer *flushTimer;
+    QString last_line_key;
+
+    enum { LOG_FORMAT_COUNT = 7 };
+    SonicPiTheme *formats_theme;
+    QTextCharFormat base_format;
+    QTextCharFormat msg_formats[LOG_FORMAT_COUNT];
+    QTextCharFormat join_formats[LOG_FORMAT_COUNT];
+    QTextCharFormat span_formats[SPAN_STYLE_COUNT];
+    int last_flush_merged;
+    int max_flush_merged;
+
+    int max_lines;
+    int spilled_lines;
+    QString history_path;
+    // one thread, so spills reach the file in order
+    QThreadPool *history_pool;
+    // only touched by jobs running on history_pool
+    SonicPiLogHistory *history;
+    QFutureWatcher<void> *history_flush_watcher;
 
 protected:
+    void contextMenuEvent(QContextMenuEvent *event);
 };
 
 Q_DECLARE_METATYPE(SonicPiLog::MultiMessage)
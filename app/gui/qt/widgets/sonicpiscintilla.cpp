@@ -13,6 +13,8 @@
 
 #include "sonicpiscintilla.h"
 #include "osc/oscsender.h"
+#include "utils/sonicpiapis.h"
+#include "utils/linediff.h"
 
 #include <QSettings>
 #include <QShortcut>
@@ -22,6 +24,10 @@
 #include <Qsci/qscicommandset.h>
 #include <Qsci/qscilexer.h>
 #include <QCheckBox>
+#include <QTimer>
+#include <cctype>
+#include <algorithm>
+#include <cstring>
 
 SonicPiScintilla::SonicPiScintilla(SonicPiLexer *lexer, SonicPiTheme *theme, QString fileName, OscSender *oscSender, bool autoIndent)
   : QsciScintilla()
@@ -141,9 +147,14 @@ SonicPiScintilla::SonicPiScintilla(SonicPiLexer *lexer, SonicPiTheme *theme, QSt
   markerDefine(RightArrow, 8);
   setMarkerBackgroundColor(theme->color("MarkerBackground"), 8);
 
+  // completion lists are ranked by SonicPiAPIs and shown by
+  // showCompletions, QScintilla would re-sort them alphabetically
   setAutoCompletionThreshold(1);
-  setAutoCompletionSource(SonicPiScintilla::AcsAPIs);
+  setAutoCompletionSource(SonicPiScintilla::AcsNone);
   setAutoCompletionCaseSensitivity(false);
+  connect(this, SIGNAL(SCN_CHARADDED(int)), this, SLOT(completionCharAdded(int)));
+  connect(this, SIGNAL(SCN_MODIFIED(int, int, const char *, int, int, int, int, int, int, int)), this, SLOT(bufferModified(int, int, const char *, int, int)));
+  connect(this, SIGNAL(SCN_AUTOCSELECTION(const char *, int)), this, SLOT(completionChosen(const char *, int)));
 
   setSelectionBackgroundColor(theme->color("SelectionBackground"));
   setSelectionForegroundColor(theme->color("SelectionForeground"));
@@ -565,11 +576,43 @@ void SonicPiScintilla::newLine() {
 
 void SonicPiScintilla::replaceBuffer(QString content, int line, int index, int first_line) {
   mutex->lock();
+  // only touch what changed, so Scintilla doesn't re-lex and lay out
+  // the whole buffer, undo stays small and markers stay put
+  QStringList from = splitLines(text());
+  QStringList to = splitLines(content);
+  QVector<LineDiffHunk> hunks = diffLines(from, to);
+
+  // document position of the start of each old line
+  QVector<int> starts(from.size() + 1);
+  starts[0] = 0;
+  for (int i = 0; i < from.size(); i++) {
+    starts[i + 1] = starts[i] + from[i].toUtf8().size();
+  }
+
   beginUndoAction();
-  insert(" ");
-  SendScintilla(QsciCommand::Delete);
-  selectAll();
-  replaceSelectedText(content);
+  // bottom up, so the positions above each hunk are still valid
+  for (int h = hunks.size() - 1; h >= 0; h--) {
+    const LineDiffHunk &hunk = hunks[h];
+    QString old_text = QStringList(from.mid(hunk.old_start, hunk.old_count)).join("");
+    QString new_text = QStringList(to.mid(hunk.new_start, hunk.new_count)).join("");
+
+    // within the lines, leave alone the characters either end that
+    // match, eg the code after re-indented whitespace
+    int prefix = 0;
+    while (prefix < old_text.length() && prefix < new_text.length() && old_text[prefix] == new_text[prefix]) prefix++;
+    if (prefix > 0 && old_text[prefix - 1].isHighSurrogate()) prefix--;
+    int suffix = 0;
+    while (suffix < old_text.length() - prefix && suffix < new_text.length() - prefix &&
+           old_text[old_text.length() - 1 - suffix] == new_text[new_text.length() - 1 - suffix]) suffix++;
+    if (suffix > 0 && old_text[old_text.length() - suffix].isLowSurrogate()) suffix--;
+
+    int start = starts[hunk.old_start] + old_text.left(prefix).toUtf8().size();
+    int end = starts[hunk.old_start + hunk.old_count] - old_text.right(suffix).toUtf8().size();
+    QByteArray replacement = new_text.mid(prefix, new_text.length() - prefix - suffix).toUtf8();
+    SendScintilla(SCI_SETTARGETSTART, start);
+    SendScintilla(SCI_SETTARGETEND, end);
+    SendScintilla(SCI_REPLACETARGET, (unsigned long)replacement.size(), replacement.constData());
+  }
   setCursorPosition(line, index);
   setFirstVisibleLine(first_line);
   endUndoAction();
@@ -591,18 +634,66 @@ void SonicPiScintilla::completeListOrNewlineAndIndent(){
   mutex->unlock();
 }
 
-void SonicPiScintilla::newlineAndIndent() {
-  mutex->lock();
-  int point_line, point_index, first_line;
-  getCursorPosition(&point_line, &point_index);
-  first_line = firstVisibleLine();
+void SonicPiScintilla::bufferModified(int position, int modificationType, const char *text, int length, int linesAdded) {
+  Q_UNUSED(text);
+  Q_UNUSED(length);
+  if (modificationType & (SC_MOD_INSERTTEXT | SC_MOD_DELETETEXT)) {
+    int line = SendScintilla(SCI_LINEFROMPOSITION, position);
+    blockIndex.linesChanged(line, linesAdded);
+  }
+}
 
-  std::string code = text().toStdString();
+// Rescans the edited lines up to and including line, or all of them
+// if line is -1.
+void SonicPiScintilla::rescanBlocks(int line) {
+  int dirty;
+  while ((dirty = blockIndex.nextDirtyLine()) >= 0 && (line < 0 || dirty <= line)) {
+    blockIndex.rescanLine(dirty, text(dirty));
+  }
+}
 
-  // TODO: fix this:
-  std::string id = "foobar";
+RubyBlockIndex &SonicPiScintilla::blockStructure() {
+  rescanBlocks(-1);
+  return blockIndex;
+}
+
+int SonicPiScintilla::indentLevel(int line) {
+  rescanBlocks(line);
+  return blockIndex.indentLevel(line);
+}
+
+void SonicPiScintilla::newlineAndIndent() {
+  mutex->lock();
+  int pos = SendScintilla(SCI_GETCURRENTPOS);
+  int line = SendScintilla(SCI_LINEFROMPOSITION, pos);
+  int line_start = SendScintilla(SCI_POSITIONFROMLINE, line);
+  int line_end = SendScintilla(SCI_GETLINEENDPOSITION, line);
+
+  // like the beautifier, drop the whitespace either side of the point
+  auto blank = [this](int p) {
+    int ch = SendScintilla(SCI_GETCHARAT, p);
+    return ch == ' ' || ch == '\t';
+  };
+  int keep_end = pos;
+  while (keep_end > line_start && blank(keep_end - 1)) keep_end--;
+  int rest_start = pos;
+  while (rest_start < line_end && blank(rest_start)) rest_start++;
 
-  oscSender->bufferNewlineAndIndent(point_line, point_index, first_line, code, fileName.toStdString(), id);
+  beginUndoAction();
+  SendScintilla(SCI_SETTARGETSTART, keep_end);
+  SendScintilla(SCI_SETTARGETEND, rest_start);
+  SendScintilla(SCI_REPLACETARGET, (unsigned long)1, "\n");
+
+  // the split line may now start with end or else, so indent it again
+  // unless it is blank
+  int level = indentLevel(line);
+  if (level >= 0 && keep_end > line_start) {
+    setIndentation(line, level * indentationWidth());
+  }
+  level = indentLevel(line + 1);
+  setIndentation(line + 1, std::max(level, 0) * indentationWidth());
+  SendScintilla(SCI_GOTOPOS, SendScintilla(SCI_GETLINEINDENTPOSITION, line + 1));
+  endUndoAction();
   mutex->unlock();
 }
 
@@ -651,6 +742,61 @@ void SonicPiScintilla::dropEvent(QDropEvent *dropEvent) {
   mutex->unlock();
 }
 
+SonicPiAPIs *SonicPiScintilla::completionAPIs() {
+  QsciLexer *lex = lexer();
+  return lex ? dynamic_cast<SonicPiAPIs *>(lex->apis()) : 0;
+}
+
+void SonicPiScintilla::completionCharAdded(int ch) {
+  if (ch > 0 && ch < 128 && (isalnum(ch) || strchr(":_?!", ch))) {
+    // let Scintilla finish with the character before replacing the list
+    QTimer::singleShot(0, this, SLOT(showCompletions()));
+  }
+}
+
+void SonicPiScintilla::showCompletions() {
+  mutex->lock();
+  SonicPiAPIs *apis = completionAPIs();
+  int context_start, last_word_start;
+  QStringList context = apiContext(SendScintilla(SCI_GETCURRENTPOS), context_start, last_word_start);
+  QStringList words;
+  if (apis && !context.isEmpty() && !context.last().isEmpty()) {
+    words = apis->rankedCompletions(context);
+  }
+
+  if (words.isEmpty()) {
+    if (isListActive()) cancelList();
+    mutex->unlock();
+    return;
+  }
+
+  QByteArray partial = context.last().toUtf8();
+  QByteArray best = words.first().toUtf8();
+#if QSCINTILLA_VERSION >= 0x020901
+  // keep the ranking rather than Scintilla's alphabetical order
+  SendScintilla(SCI_AUTOCSETORDER, SC_ORDER_CUSTOM);
+#else
+  words.sort();
+#endif
+  QByteArray list = words.join(QChar('\x03')).toUtf8();
+  SendScintilla(SCI_AUTOCSETSEPARATOR, '\x03');
+  SendScintilla(SCI_AUTOCSETTYPESEPARATOR, '\x04');
+  SendScintilla(SCI_AUTOCSETIGNORECASE, true);
+  SendScintilla(SCI_AUTOCSHOW, (unsigned long)partial.length(), list.constData());
+  // fuzzy matches don't start with what was typed, so pick the best
+  // one explicitly
+  SendScintilla(SCI_AUTOCSELECT, (unsigned long)0, best.constData());
+  mutex->unlock();
+}
+
+void SonicPiScintilla::completionChosen(const char *selection, int position) {
+  Q_UNUSED(position);
+  SonicPiAPIs *apis = completionAPIs();
+  if (apis) {
+    apis->noteCompletion(QString::fromUtf8(selection));
+  }
+}
+
 void SonicPiScintilla::sp_paste() {
   mutex->lock();
   SendScintilla(QsciCommand::Paste);
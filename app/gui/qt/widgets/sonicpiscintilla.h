@@ -15,9 +15,11 @@
 #include "model/sonicpitheme.h"
 #include "osc/oscsender.h"
 #include "widgets/sonicpilog.h"
+#include "utils/rubyblockindex.h"
 #include <QCheckBox>
 
 class SonicPiLexer;
+class SonicPiAPIs;
 class QSettings;
 
 class SonicPiScintilla : public QsciScintilla
@@ -36,6 +38,9 @@ class SonicPiScintilla : public QsciScintilla
 
   void redraw();
 
+  // live_loop, define, do ... end and other blocks in the buffer
+  RubyBlockIndex &blockStructure();
+
   public slots:
     void cutLineFromPoint();
     void tabCompleteifList();
@@ -74,7 +79,17 @@ class SonicPiScintilla : public QsciScintilla
     void sp_paste();
     void sp_cut();
 
+    void showCompletions();
+
+ private slots:
+    void bufferModified(int position, int modificationType, const char *text, int length, int linesAdded);
+    void completionCharAdded(int ch);
+    void completionChosen(const char *selection, int position);
+
  private:
+    SonicPiAPIs *completionAPIs();
+    void rescanBlocks(int line);
+    int indentLevel(int line);
     void addKeyBinding(QSettings &qs, int cmd, int key);
     void addOtherKeyBinding(QSettings &qs, int cmd, int key);
     void dragEnterEvent(QDragEnterEvent *pEvent);
@@ -83,5 +98,6 @@ class SonicPiScintilla : public QsciScintilla
     bool event(QEvent *evt);
     bool autoIndent;
     QMutex *mutex;
+    RubyBlockIndex blockIndex;
 
 };
@@ -221,7 +221,7 @@ begin
   when :tcp
     osc_server = SonicPi::OSC::TCPServer.new(server_port, use_decoder_cache: true)
   when :udp
-    osc_server = SonicPi::OSC::UDPServer.new(server_port, use_decoder_cache: true)
+    osc_server = SonicPi::OSC::UDPServer.new(server_port, use_decoder_cache: true, unpack_bundles: true)
   when :websockets
     osc_server = gui
   end
@@ -527,6 +527,11 @@ register_api = lambda do |server|
     gui.send("/version", v.to_s, v.to_i, lv.to_s, lv.to_i, lc.day, lc.month, lc.year, plat.to_s)
   end
 
+  server.add_method("/scsynth-info") do |args|
+    gui_id = args[0]
+    gui.send("/scsynth/info", sp.scsynth_info[:sample_rate].to_f)
+  end
+
   server.add_method("/gui-heartbeat") do |args|
     gui_id = args[0]
     sp.__gui_heartbeat gui_id
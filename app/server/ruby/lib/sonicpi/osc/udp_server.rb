@@ -20,6 +20,7 @@ module SonicPi
 
       def initialize(port, opts={}, &global_method)
         open = opts[:open]
+        @unpack_bundles = opts[:unpack_bundles]
         @port = port
         @opts = opts
         @socket = UDPSocket.new
@@ -82,20 +83,46 @@ module SonicPi
             redo
           end
 
-          begin
-            address, args = @decoder.decode_single_message(osc_data)
-            log "OSC <-----        #{address} #{args.inspect}" if incoming_osc_debug_mode
-            if @global_matcher
-              @global_matcher.call(address, args, sender_addrinfo)
-            else
-              p = @matchers[address]
-              p.call(args) if p
+          dispatch(osc_data, sender_addrinfo)
+        end
+      end
+
+      # With unpack_bundles: true (only the GUI API server, whose GUI
+      # batches small messages) bundles are unpacked recursively and each
+      # message dispatched in order as soon as it arrives. Time tags are
+      # ignored, so a bundle scheduled for the future is handled now.
+      # Other servers reject bundles as before.
+      def dispatch(osc_data, sender_addrinfo)
+        if @unpack_bundles && osc_data.start_with?("#bundle\0")
+          # elements follow the 8 byte header and 8 byte time tag, each
+          # prefixed by its size
+          pos = 16
+          while pos + 4 <= osc_data.bytesize
+            size = osc_data.byteslice(pos, 4).unpack("N")[0]
+            pos += 4
+            if pos + size > osc_data.bytesize
+              STDERR.puts "OSC bundle element of #{size} bytes overruns the #{osc_data.bytesize} byte packet, dropping the rest"
+              return
             end
-          rescue Exception => e
-            STDERR.puts "OSC handler exception for address: #{address}"
-            STDERR.puts e.message
-            STDERR.puts e.backtrace.inspect
+            dispatch(osc_data.byteslice(pos, size), sender_addrinfo)
+            pos += size
+          end
+          return
+        end
+
+        begin
+          address, args = @decoder.decode_single_message(osc_data)
+          log "OSC <-----        #{address} #{args.inspect}" if incoming_osc_debug_mode
+          if @global_matcher
+            @global_matcher.call(address, args, sender_addrinfo)
+          else
+            p = @matchers[address]
+            p.call(args) if p
           end
+        rescue Exception => e
+          STDERR.puts "OSC handler exception for address: #{address}"
+          STDERR.puts e.message
+          STDERR.puts e.backtrace.inspect
         end
       end
     end
@@ -45,5 +45,64 @@ module SonicPi
         assert_equal(args, d_args)
       end
     end
+
+    def dispatched(osc_data, opts={unpack_bundles: true})
+      calls = []
+      server = OSC::UDPServer.new(0, opts) { |address, args, sender| calls << [address, args] }
+      server.__send__(:dispatch, osc_data, nil)
+      calls
+    ensure
+      server.stop if server
+    end
+
+    def bundle(*elements)
+      "#bundle\0" + [0, 1].pack("NN") + elements.map { |e| [e.bytesize].pack("N") + e }.join
+    end
+
+    def test_dispatch_single_message
+      m = FastOsc.encode_single_message("/foo", [1, "bar"])
+      assert_equal([["/foo", [1, "bar"]]], dispatched(m))
+    end
+
+    def test_dispatch_bundle_in_order
+      a = FastOsc.encode_single_message("/a", [1])
+      b = FastOsc.encode_single_message("/b", [2.0])
+      assert_equal([["/a", [1]], ["/b", [2.0]]], dispatched(bundle(a, b)))
+    end
+
+    def test_dispatch_nested_bundles
+      a = FastOsc.encode_single_message("/a", [1])
+      b = FastOsc.encode_single_message("/b", [2])
+      c = FastOsc.encode_single_message("/c", ["three"])
+      assert_equal([["/a", [1]], ["/b", [2]], ["/c", ["three"]]],
+                   dispatched(bundle(a, bundle(b, bundle()), c)))
+    end
+
+    def test_dispatch_bundle_ignores_time_tag
+      # a bundle timed for the future is still dispatched straight away
+      m = FastOsc.encode_single_bundle(Time.now.to_f + 60, "/later", [1])
+      assert_equal([["/later", [1]]], dispatched(m))
+    end
+
+    def test_dispatch_bundle_not_unpacked_by_default
+      # servers other than the GUI API one keep rejecting bundles rather
+      # than firing timed messages early
+      m = FastOsc.encode_single_bundle(Time.now.to_f + 60, "/later", [1])
+      calls = nil
+      capture_subprocess_io { calls = dispatched(m, {}) }
+      refute_includes(calls.map(&:first), "/later")
+    end
+
+    def test_dispatch_bundle_with_oversized_element
+      a = FastOsc.encode_single_message("/a", [1])
+      b = FastOsc.encode_single_message("/b", [2])
+      bad = bundle(a, b)
+      # claim the second element runs past the end of the packet
+      bad[16 + 4 + a.bytesize, 4] = [b.bytesize + 4].pack("N")
+      calls = nil
+      _, err = capture_subprocess_io { calls = dispatched(bad) }
+      assert_match(/overruns/, err)
+      assert_equal([["/a", [1]]], calls)
+    end
   end
 end